@@ -0,0 +1,233 @@
+#include "concurrency.h"
+
+#include <QThreadPool>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "src/logger/log.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Adaptive limit starts at the number of jobs and may grow up to this number of blames per job.
+constexpr int cMaxAdaptiveGitJobsPerJob = 4;
+// Throughput is measured over windows of at least this time and at least 'limit' blames.
+constexpr auto cAdaptiveWindow = std::chrono::milliseconds(500);
+// Smaller differences of throughput between windows are treated as noise.
+constexpr double cThroughputTolerance = 0.05;
+// Limit is not raised, when there are more runnable processes per core.
+constexpr double cMaxLoadPerCore = 2.0;
+
+bool isOverloaded()
+{
+#ifdef Q_OS_UNIX
+	double load{};
+	const auto cores = std::max(1u, std::thread::hardware_concurrency());
+	return getloadavg(&load, 1) == 1 && load > cMaxLoadPerCore * cores;
+#else
+	return false;
+#endif
+}
+
+// Hill climbing over the number of blames in flight: the limit moves in one direction, while
+// throughput grows, turns around, when it drops, and goes down on a plateau, because the same
+// throughput with fewer processes leaves more CPU to the rest of the machine.
+struct AdaptiveController
+{
+	AdaptiveController(concurrency::Limiter &limiter, int maxLimit)
+	    : m_limiter(limiter)
+	    , m_maxLimit(maxLimit)
+	{}
+
+	void onBlameFinished()
+	{
+		std::lock_guard l(m_mutex);
+
+		m_completions++;
+		const auto now = Clock::now();
+		const auto elapsed = now - m_windowStart;
+		const int limit = m_limiter.limit();
+		if (elapsed < cAdaptiveWindow || m_completions < limit) {
+			return;
+		}
+
+		const double throughput =
+		    m_completions / std::chrono::duration<double>(elapsed).count();
+		if (throughput > m_prevThroughput * (1 + cThroughputTolerance)) {
+			// Keep direction.
+		} else if (throughput < m_prevThroughput * (1 - cThroughputTolerance)) {
+			m_direction = -m_direction;
+		} else {
+			m_direction = -1;
+		}
+
+		if (m_direction > 0 && isOverloaded()) {
+			m_direction = -1;
+		}
+
+		const int newLimit = std::clamp(limit + m_direction, 1, m_maxLimit);
+		if (newLimit == limit) {
+			m_direction = -m_direction;
+		} else {
+			m_limiter.setLimit(newLimit);
+			CN_DEBUG("Git jobs limit" << newLimit << "after" << throughput << "blames/s");
+		}
+
+		m_prevThroughput = throughput;
+		m_completions = 0;
+		m_windowStart = now;
+	}
+
+private:
+	concurrency::Limiter &m_limiter;
+	const int m_maxLimit;
+
+	std::mutex m_mutex;
+	Clock::time_point m_windowStart = Clock::now();
+	int m_completions = 0;
+	double m_prevThroughput = 0;
+	int m_direction = 1;
+};
+
+struct State
+{
+	State(int gitJobs, int maxGitJobs, bool isAdaptive)
+	    : git(gitJobs)
+	{
+		if (isAdaptive) {
+			controller = std::make_unique<AdaptiveController>(git, maxGitJobs);
+		}
+	}
+
+	concurrency::Limiter git;
+	std::unique_ptr<AdaptiveController> controller;
+};
+
+QThreadPool gPool;
+// Is created before files are started, so it is not guarded. Null, if git slots are not limited.
+std::unique_ptr<State> gState;
+int gMaxFilesInFlight = 1;
+
+}  // namespace
+
+namespace concurrency {
+
+Limiter::Limiter(int limit) noexcept
+    : m_limit(std::max(1, limit))
+{}
+
+bool Limiter::acquireOrQueue(std::coroutine_handle<> waiter)
+{
+	std::lock_guard l(m_mutex);
+	if (m_taken < m_limit) {
+		m_taken++;
+		return true;
+	}
+
+	m_waiters.emplace_back(waiter);
+	return false;
+}
+
+void Limiter::release()
+{
+	std::coroutine_handle<> next;
+	{
+		std::lock_guard l(m_mutex);
+		// The slot is passed to the first waiter, unless the limit has shrunk.
+		if (!m_waiters.empty() && m_taken <= m_limit) {
+			next = m_waiters.front();
+			m_waiters.pop_front();
+		} else {
+			m_taken--;
+		}
+	}
+
+	if (next) {
+		resume(next);
+	}
+}
+
+void Limiter::setLimit(int limit)
+{
+	std::vector<std::coroutine_handle<>> woken;
+	{
+		std::lock_guard l(m_mutex);
+		m_limit = std::max(1, limit);
+		while (!m_waiters.empty() && m_taken < m_limit) {
+			woken.emplace_back(m_waiters.front());
+			m_waiters.pop_front();
+			m_taken++;
+		}
+	}
+
+	for (const auto waiter : woken) {
+		resume(waiter);
+	}
+}
+
+int Limiter::limit() const
+{
+	std::lock_guard l(m_mutex);
+	return m_limit;
+}
+
+void init(int jobs, int gitJobs, bool isAdaptive)
+{
+	jobs = std::max(1, jobs);
+	gPool.setMaxThreadCount(jobs);
+
+	const int initialGitJobs = gitJobs > 0 ? gitJobs : jobs;
+	const int maxGitJobs = isAdaptive ? cMaxAdaptiveGitJobsPerJob * jobs : initialGitJobs;
+	gState = std::make_unique<State>(initialGitJobs, maxGitJobs, isAdaptive);
+	gMaxFilesInFlight = jobs + maxGitJobs;
+}
+
+int maxFilesInFlight()
+{
+	return gMaxFilesInFlight;
+}
+
+void post(std::function<void()> task)
+{
+	gPool.start(std::move(task));
+}
+
+void resume(std::coroutine_handle<> handle)
+{
+	post([handle] { handle.resume(); });
+}
+
+void waitForDone()
+{
+	gPool.waitForDone();
+}
+
+bool GitSlotAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+	return gState && !gState->git.acquireOrQueue(handle);
+}
+
+GitSlotAwaiter acquireGitSlot()
+{
+	return {};
+}
+
+void releaseGitSlot()
+{
+	if (!gState) {
+		return;
+	}
+
+	gState->git.release();
+	if (gState->controller) {
+		gState->controller->onBlameFinished();
+	}
+}
+
+}  // namespace concurrency
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <coroutine>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+// Execution of file tasks, which are set with --jobs and --git-jobs. Files are processed by
+// coroutines on --jobs threads, which are suspended, while they wait for git, so threads are not
+// blocked by git processes, and the number of blames in flight is limited separately.
+namespace concurrency {
+
+// Coroutine, which starts immediately and destroys its frame, when it is finished. It is resumed on
+// the pool after every suspension.
+struct Task
+{
+	struct promise_type
+	{
+		Task get_return_object() noexcept { return {}; }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() noexcept {}
+		void unhandled_exception() noexcept { std::terminate(); }
+	};
+};
+
+// Counting semaphore for coroutines, which limit can be changed while slots are taken.
+struct Limiter
+{
+	explicit Limiter(int limit) noexcept;
+
+	// Takes a slot or queues 'waiter', which is resumed on the pool, when it gets a slot.
+	[[nodiscard]] bool acquireOrQueue(std::coroutine_handle<> waiter);
+	void release();
+	// If limit shrinks, taken slots are not revoked, but new ones are not given, until the number
+	// of taken slots is below the new limit.
+	void setLimit(int limit);
+	[[nodiscard]] int limit() const;
+
+private:
+	mutable std::mutex m_mutex;
+	std::deque<std::coroutine_handle<>> m_waiters;
+	int m_limit;
+	int m_taken = 0;
+};
+
+// Without 'gitJobs' and adaptive mode, the number of blames is limited by 'jobs'.
+void init(int jobs, int gitJobs, bool isAdaptive);
+// Maximum number of files, which are running or waiting for git.
+[[nodiscard]] int maxFilesInFlight();
+
+// Runs 'task' on one of --jobs threads.
+void post(std::function<void()> task);
+void resume(std::coroutine_handle<> handle);
+// Waits for posted tasks and stops the threads.
+void waitForDone();
+
+struct GitSlotAwaiter
+{
+	[[nodiscard]] bool await_ready() const noexcept { return false; }
+	[[nodiscard]] bool await_suspend(std::coroutine_handle<> handle);
+	void await_resume() const noexcept {}
+};
+
+// Must be released with releaseGitSlot() or GitSlotGuard. In adaptive mode the limit of git slots
+// follows the blame throughput.
+[[nodiscard]] GitSlotAwaiter acquireGitSlot();
+void releaseGitSlot();
+
+// Releases the acquired git slot, when it leaves the scope, so the slot is not lost, if the blame
+// throws. release() gives the slot back earlier.
+class GitSlotGuard
+{
+public:
+	GitSlotGuard() = default;
+	~GitSlotGuard() { release(); }
+	GitSlotGuard(const GitSlotGuard &) = delete;
+	GitSlotGuard &operator=(const GitSlotGuard &) = delete;
+
+	void release()
+	{
+		if (m_isAcquired) {
+			m_isAcquired = false;
+			releaseGitSlot();
+		}
+	}
+
+private:
+	bool m_isAcquired = true;
+};
+
+}  // namespace concurrency
@@ -3,9 +3,11 @@
 #include <mutex>
 #include <QCommandLineParser>
 #include <QDir>
+#include <QFileInfo>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QThread>
 
 #include "src/file_utils/file_utils.h"
 #include "src/logger/log.h"
@@ -46,13 +48,75 @@ QCommandLineOption maxBlameAuthors{
     "Update author list only if blame authors <= some limit. "
     "Should be a positive number (0 or -1 mean 'unlimited' and used by default).", "number", "0"};
 
+QCommandLineOption maxHeaderOffset{
+    "max-header-offset",
+    "Look for header start only within first bytes of file. "
+    "Should be a non-negative number (0 means 'unlimited').", "bytes",
+    QString::number(appconst::cMaxHeaderOffset)};
+
 QCommandLineOption dontSkipBrokenMerges{
     "dont-skip-broken-merges", "Do not skip broken merge commits."};
 
 QCommandLineOption staticConfigPath{
     "static-config", "Json configuration file with static configuration.", "path"};
 QCommandLineOption dry{"dry", "Do not modify files, print to stdout instead."};
+QCommandLineOption check{
+    "check", "Do not modify files, stop at the first file with outdated header and exit with "
+             "code 10."};
+QCommandLineOption checkAll{
+    "check-all", "Do not modify files, list every file with outdated header and exit with code 10."};
+QCommandLineOption shard{
+    "shard", "Process only i-th of N deterministic parts of the files (e.g. 2/4).", "i/N"};
+QCommandLineOption shardCosts{
+    "shard-costs", "Shard report of a previous run to balance shards by file processing time.",
+    "path"};
+QCommandLineOption report{
+    "report", "Write JSON Lines report with result and timings of every file.", "path"};
+QCommandLineOption emitPatch{
+    "emit-patch",
+    "Do not modify files, write header changes of all files as one patch for 'git apply'.",
+    "path"};
+QCommandLineOption commitTo{
+    "commit-to",
+    "Do not modify files, commit updated files on top of HEAD (or --rev) and move this branch or "
+    "ref to the commit.",
+    "ref"};
+QCommandLineOption rev{
+    "rev",
+    "Treat paths as repositories (bare ones too), read files of this commit instead of the working "
+    "tree and do not modify files, unless --commit-to is set.",
+    "commit"};
+QCommandLineOption staged{
+    "staged",
+    "Treat paths as repositories, process only files staged in their index and write updated files "
+    "to both the index and the working tree."};
+const QLatin1String cRefsPrefix("refs/");
+const QLatin1String cBranchesPrefix("refs/heads/");
+QCommandLineOption mergeShardReports{
+    "merge-shard-reports",
+    "Treat paths as shard reports, merge them into --report and exit with combined code."};
 QCommandLineOption verbose{"verbose", "Print verbose output."};
+
+QCommandLineOption profile{"profile",
+                           "Print time spent in every processing stage, slowest files and git "
+                           "subprocess statistics on exit."};
+
+QCommandLineOption trace{
+    "trace", "Write Chrome trace events of every file and its stages on every worker thread.",
+    "path"};
+
+QCommandLineOption jobs{
+    "jobs", "Process at most this number of files at once (number of cores by default).",
+    "number"};
+const QLatin1String cAutoGitJobs("auto");
+QCommandLineOption gitJobs{
+    "git-jobs",
+    "Run at most this number of blames at once, besides --jobs files. 'auto' adjusts the number "
+    "to the highest blame throughput.",
+    "number|auto"};
+
+QCommandLineOption dropLogs{"drop-logs",
+                            "Drop log messages instead of waiting, when logging can not keep up."};
 // clang-format on
 
 void addOptions(QCommandLineParser &parser)
@@ -69,16 +133,45 @@ void addOptions(QCommandLineParser &parser)
 	    , updateAuthors
 	    , updateAuthorsOnlyIfEmpty
 		, maxBlameAuthors
+	    , maxHeaderOffset
 	    , dontSkipBrokenMerges
 	    , staticConfigPath
 	    , dry
+	    , check
+	    , checkAll
+	    , shard
+	    , shardCosts
+	    , report
+	    , emitPatch
+	    , commitTo
+	    , rev
+	    , staged
+	    , mergeShardReports
+	    , jobs
+	    , gitJobs
 	    , verbose
+	    , profile
+	    , trace
+	    , dropLogs
 	});
 	// clang-format on
 
 	parser.addPositionalArgument("file_or_dir", "File or directory to process.", "[paths...]");
 }
 
+// File is created or truncated after all files are processed, so its directory has to be writable,
+// if it does not exist yet.
+bool isWritableFile(const QString &path)
+{
+	const QFileInfo file(path);
+	if (file.exists()) {
+		return file.isFile() && file.isWritable();
+	}
+
+	const QFileInfo dir(file.absolutePath());
+	return dir.isDir() && dir.isWritable();
+}
+
 }  // namespace
 
 RunConfig::RunConfig(const QStringList &arguments) noexcept
@@ -89,6 +182,16 @@ RunConfig::RunConfig(const QStringList &arguments) noexcept
 
 	if (parser.isSet(verbose)) {
 		m_runOptions |= RunOption::Verbose;
+		// Debug messages of the configuration are logged before logger::init().
+		logger::setVerbose(true);
+	}
+
+	if (parser.isSet(profile)) {
+		m_runOptions |= RunOption::Profile;
+	}
+
+	if (parser.isSet(dropLogs)) {
+		m_runOptions |= RunOption::DropLogsOnOverflow;
 	}
 
 	if (parser.isSet(::componentName)) {
@@ -130,6 +233,41 @@ RunConfig::RunConfig(const QStringList &arguments) noexcept
 		m_maxBlameAuthors = m_maxBlameAuthors > 0 ? m_maxBlameAuthors : maxInt;
 	}
 
+	if (parser.isSet(::maxHeaderOffset)) {
+		bool isOk{};
+		m_maxHeaderOffset = parser.value(::maxHeaderOffset).toInt(&isOk);
+		if (!isOk || m_maxHeaderOffset < 0) {
+			CN_ERR(Msg::BadMaxHeaderOffset,
+			       ::maxHeaderOffset.names().first() << " should be a non-negative number (0 "
+			                                            "means 'unlimited').");
+			parser.showHelp(apperror::RunArgError);
+		}
+	}
+
+	m_jobs = QThread::idealThreadCount();
+	if (parser.isSet(::jobs)) {
+		bool isOk{};
+		m_jobs = parser.value(::jobs).toInt(&isOk);
+		if (!isOk || m_jobs <= 0) {
+			CN_ERR(Msg::BadJobs, ::jobs.names().first() << " should be a positive number.");
+			parser.showHelp(apperror::RunArgError);
+		}
+	}
+
+	if (parser.isSet(::gitJobs)) {
+		const auto value = parser.value(::gitJobs);
+		bool isOk{};
+		m_gitJobs = value.toInt(&isOk);
+		if (value == cAutoGitJobs) {
+			m_runOptions |= RunOption::AdaptiveGitJobs;
+			m_gitJobs = 0;
+		} else if (!isOk || m_gitJobs <= 0) {
+			CN_ERR(Msg::BadJobs, ::gitJobs.names().first() << " should be a positive number or '"
+			                                                << cAutoGitJobs << "'.");
+			parser.showHelp(apperror::RunArgError);
+		}
+	}
+
 	if (parser.isSet(dontSkipBrokenMerges)) {
 		m_runOptions |= RunOption::DontSkipBrokenMerges;
 	}
@@ -156,6 +294,90 @@ RunConfig::RunConfig(const QStringList &arguments) noexcept
 		m_runOptions |= RunOption::ReadOnlyMode;
 	}
 
+	if (parser.isSet(check) || parser.isSet(checkAll)) {
+		m_runOptions |= RunOption::ReadOnlyMode;
+		m_runOptions |= RunOption::CheckMode;
+		if (parser.isSet(checkAll)) {
+			m_runOptions |= RunOption::CheckAllMode;
+		}
+	}
+
+	if (parser.isSet(::shard)) {
+		const auto shardParts = parser.value(::shard).split('/');
+		bool isIndexOk{};
+		bool isCountOk{};
+		const int index = shardParts.size() == 2 ? shardParts.first().toInt(&isIndexOk) : 0;
+		const int count = shardParts.size() == 2 ? shardParts.last().toInt(&isCountOk) : 0;
+
+		if (!isIndexOk || !isCountOk || index < 1 || index > count) {
+			CN_ERR(Msg::BadShardOption, ::shard.names().first() << " should be in form i/N, where "
+			                                                       "1 <= i <= N.");
+			parser.showHelp(apperror::RunArgError);
+		}
+
+		m_shardIndex = index - 1;
+		m_shardCount = count;
+	}
+
+	if (parser.isSet(::shardCosts)) {
+		m_shardCostsPath = QDir::cleanPath(parser.value(::shardCosts));
+	}
+
+	if (parser.isSet(::report)) {
+		m_reportPath = QDir::cleanPath(parser.value(::report));
+	}
+
+	if (parser.isSet(::emitPatch)) {
+		m_patchPath = QDir::cleanPath(parser.value(::emitPatch));
+		if (!isWritableFile(m_patchPath)) {
+			CN_ERR(Msg::BadPatch,
+			       ::emitPatch.names().first() << " can not write to " << m_patchPath << '.');
+			parser.showHelp(apperror::RunArgError);
+		}
+		m_runOptions |= RunOption::ReadOnlyMode;
+	}
+
+	if (parser.isSet(::commitTo)) {
+		m_commitRef = parser.value(::commitTo);
+		if (m_commitRef.isEmpty()) {
+			CN_ERR(Msg::BadCommitRef, ::commitTo.names().first() << " should not be empty string.");
+			parser.showHelp(apperror::RunArgError);
+		}
+		if (!m_commitRef.startsWith(cRefsPrefix)) {
+			m_commitRef.prepend(cBranchesPrefix);
+		}
+	}
+
+	if (parser.isSet(::rev)) {
+		m_revision = parser.value(::rev);
+		if (m_revision.isEmpty()) {
+			CN_ERR(Msg::BadRevision, ::rev.names().first() << " should not be empty string.");
+			parser.showHelp(apperror::RunArgError);
+		}
+		m_runOptions |= RunOption::RevisionMode;
+		// There is no working tree to write files to, so only commit can be written.
+		if (m_commitRef.isEmpty()) {
+			m_runOptions |= RunOption::ReadOnlyMode;
+		}
+	}
+
+	if (parser.isSet(::staged)) {
+		if (m_runOptions.testFlag(RunOption::RevisionMode)) {
+			CN_ERR(Msg::BadRevision,
+			       ::staged.names().first() << " can not be used with " << ::rev.names().first());
+			parser.showHelp(apperror::RunArgError);
+		}
+		m_runOptions |= RunOption::StagedMode;
+	}
+
+	if (parser.isSet(::trace)) {
+		m_tracePath = QDir::cleanPath(parser.value(::trace));
+	}
+
+	if (parser.isSet(mergeShardReports)) {
+		m_runOptions |= RunOption::MergeShardReports;
+	}
+
 	m_targetPaths = parser.positionalArguments();
 	if (m_targetPaths.isEmpty() || m_targetPaths.first().isEmpty()) {
 		CN_ERR(Msg::BadTargetPaths, "'file_or_dir' should not be empty string.");
@@ -175,7 +397,7 @@ StaticConfig getStaticConfig(const QString &path)
 	const auto handleError = [&path](const auto &action) {
 		CN_ERR(Msg::BadStaticConfigFormat,
 		       QString("Error parsing static config '%1': %2").arg(path, action));
-		std::exit(apperror::RunArgError);
+		throw std::exception();
 	};
 
 	const auto content = file_utils::readFile(path);
@@ -185,13 +407,11 @@ StaticConfig getStaticConfig(const QString &path)
 
 	if (root.isEmpty()) {
 		handleError("root object is empty");
-		return {};
 	}
 
 	const auto aliasesVal = root.value(cAuthorAliases);
 	if (!root.contains(cAuthorAliases) || !aliasesVal.isObject()) {
 		handleError(QString("map '%1' not found").arg(cAuthorAliases));
-		return {};
 	}
 
 	AuthorAliasesMap authorAliases;
@@ -204,13 +424,11 @@ StaticConfig getStaticConfig(const QString &path)
 	const auto copyrightFieldTemplateVal = root.value(cCopyrightFieldTemplate);
 	if (!root.contains(cCopyrightFieldTemplate) || !copyrightFieldTemplateVal.isString()) {
 		handleError(QString("string '%1' not found").arg(cCopyrightFieldTemplate));
-		return {};
 	}
 
 	const auto excludedPathSectionsVal = root.value(cExcludedPathSections);
 	if (!root.contains(cExcludedPathSections) || !excludedPathSectionsVal.isArray()) {
 		handleError(QString("array '%1' not found").arg(cExcludedPathSections));
-		return {};
 	}
 
 	ExcludedPathSections excludedPathSections;
@@ -2,6 +2,8 @@
 
 #include <QStringList>
 
+#include "src/constants.h"
+
 namespace environment {
 
 void init();
@@ -17,7 +19,15 @@ enum class RunOption {
 	UpdateAuthorsOnlyIfEmpty   = 1 << 4,
 	DontSkipBrokenMerges       = 1 << 5,
 	ReadOnlyMode               = 1 << 6,
-	Verbose                    = 1 << 7
+	Verbose                    = 1 << 7,
+	CheckMode                  = 1 << 8,
+	CheckAllMode               = 1 << 9,
+	MergeShardReports          = 1 << 10,
+	DropLogsOnOverflow         = 1 << 11,
+	Profile                    = 1 << 12,
+	AdaptiveGitJobs            = 1 << 13,
+	RevisionMode               = 1 << 14,
+	StagedMode                 = 1 << 15
 };
 Q_DECLARE_FLAGS(RunOptions, RunOption)
 // clang-format on
@@ -30,15 +40,41 @@ public:
 	[[nodiscard]] const RunOptions &options() const { return m_runOptions; }
 	[[nodiscard]] const QString &componentName() const { return m_componentName; }
 	[[nodiscard]] int maxBlameAuthors() const { return m_maxBlameAuthors; }
+	[[nodiscard]] int maxHeaderOffset() const { return m_maxHeaderOffset; }
+	[[nodiscard]] int jobs() const { return m_jobs; }
+	// 0 means, that blames are limited only by jobs() or adaptively.
+	[[nodiscard]] int gitJobs() const { return m_gitJobs; }
 	[[nodiscard]] const QString &staticConfigPath() const { return m_staticConfigPath; }
 	[[nodiscard]] const QStringList &targetPaths() const { return m_targetPaths; }
+	[[nodiscard]] int shardIndex() const { return m_shardIndex; }
+	[[nodiscard]] int shardCount() const { return m_shardCount; }
+	[[nodiscard]] const QString &shardCostsPath() const { return m_shardCostsPath; }
+	[[nodiscard]] const QString &reportPath() const { return m_reportPath; }
+	[[nodiscard]] const QString &patchPath() const { return m_patchPath; }
+	// Full name of the ref, e.g. 'refs/heads/<branch>' for a branch name.
+	[[nodiscard]] const QString &commitRef() const { return m_commitRef; }
+	// Revision, which is blamed and which files are read from with RunOption::RevisionMode.
+	[[nodiscard]] const QString &revision() const { return m_revision; }
+	[[nodiscard]] const QString &tracePath() const { return m_tracePath; }
 
+	// Throws, if the config can not be read or parsed, and loads it again on the next call then.
 	[[nodiscard]] static const struct StaticConfig &getStaticConfig(const QString &path);
 
 private:
 	RunOptions m_runOptions;
 	QString m_componentName;
 	int m_maxBlameAuthors = std::numeric_limits<int>::max();
+	int m_maxHeaderOffset = appconst::cMaxHeaderOffset;
+	int m_jobs = 1;
+	int m_gitJobs = 0;
 	QString m_staticConfigPath;
 	QStringList m_targetPaths;
+	int m_shardIndex = 0;
+	int m_shardCount = 1;
+	QString m_shardCostsPath;
+	QString m_reportPath;
+	QString m_patchPath;
+	QString m_commitRef;
+	QString m_revision = appconst::cHeadRevision;
+	QString m_tracePath;
 };
\ No newline at end of file
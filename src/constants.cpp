@@ -7,6 +7,7 @@ using QLS = const QLatin1String;
 QLS cAppDescription(
     "Ensures that files in a project under Git have a consistent copyright notice.");
 QLS cStaticConfig("static_config.json");
+QLS cHeadRevision("HEAD");
 
 QLS cEtAl("et al.");
 
@@ -16,6 +17,23 @@ QLS cAuthorAliases("author_aliases");
 QLS cCopyrightFieldTemplate("copyright_field_template");
 QLS cExcludedPathSections("excluded_path_sections");
 
+namespace report {
+
+QLS cPath("path");
+QLS cAction("action");
+QLS cChangedFields("changed_fields");
+QLS cAuthors("authors");
+QLS cName("name");
+QLS cShare("share");
+QLS cBlameLines("blame_lines");
+QLS cDurationMs("duration_ms");
+QLS cStagesMs("stages_ms");
+QLS cShard("shard");
+QLS cShardCount("shard_count");
+QLS cExitCode("exit_code");
+
+}
+
 }
 
 }  // namespace appconst
\ No newline at end of file
@@ -7,9 +7,19 @@ namespace appconst {
 
 extern const QLatin1String cAppDescription;
 extern const QLatin1String cStaticConfig;
+// Revision, that is blamed, unless --rev is set.
+extern const QLatin1String cHeadRevision;
 constexpr auto cPossibleBrokenCommitsNumber = 1000;
 constexpr auto cStartProcessTimeout = 5000;
 constexpr auto cProcessExecutionTimeout = 10000;
+// Processes, which run time grows with their input, e.g. reading a batch of blobs, wait until they
+// finish.
+constexpr auto cNoProcessTimeout = -1;
+constexpr auto cMaxHeaderOffset = 8 * 1024;
+constexpr qint64 cStreamingFileSize = 64 * 1024 * 1024;
+// Streamed files are read this far past the maximum header offset, so a header, that starts within
+// the offset, is read whole, unless it is longer.
+constexpr qint64 cMaxStreamedHeaderSize = 64 * 1024;
 
 extern const QLatin1String cEtAl;
 
@@ -17,6 +27,21 @@ namespace json {
 extern const QLatin1String cAuthorAliases;
 extern const QLatin1String cCopyrightFieldTemplate;
 extern const QLatin1String cExcludedPathSections;
+
+namespace report {
+extern const QLatin1String cPath;
+extern const QLatin1String cAction;
+extern const QLatin1String cChangedFields;
+extern const QLatin1String cAuthors;
+extern const QLatin1String cName;
+extern const QLatin1String cShare;
+extern const QLatin1String cBlameLines;
+extern const QLatin1String cDurationMs;
+extern const QLatin1String cStagesMs;
+extern const QLatin1String cShard;
+extern const QLatin1String cShardCount;
+extern const QLatin1String cExitCode;
+}
 }
 
 }  // namespace appconst
@@ -1,27 +1,48 @@
 #include "FileProcessor.h"
 
+#include <QDir>
 #include <QDirIterator>
+#include <QFileInfo>
 #include <QStringBuilder>
-#include <QThreadPool>
 
 #include <csignal>
+#include <map>
+#include <set>
 
+#include "src/concurrency/concurrency.h"
+#include "src/file_processor/git/git_helpers.h"
 #include "src/file_processor/parser/Header.h"
 #include "src/file_processor/parser/header_utils.h"
+#include "src/file_processor/patch/patch_helpers.h"
+#include "src/file_processor/report/report_helpers.h"
 #include "src/file_utils/file_utils.h"
 #include "src/logger/log.h"
+#include "src/profiler/profiler.h"
 
 namespace {
 
 using Msg = logger::MsgCode;
 
-QThreadPool gThreadPool;
-std::mutex gThreadPoolMutex;
+// Files are read in batches of this size, where io_uring is available, and so are blobs.
+constexpr std::size_t cReadBatchSize = 64;
+
+std::atomic_bool gIsCancelled = false;
+
+// Queued files are skipped and running ones stop at the next stage. Only the flag is set, so it is
+// safe in a signal handler, and no suspended file is lost, that the main thread waits for.
+void cancelPendingFiles()
+{
+	gIsCancelled.store(true, std::memory_order_relaxed);
+}
 
 void onTermination(int)
 {
-	std::lock_guard l(gThreadPoolMutex);
-	gThreadPool.clear();
+	cancelPendingFiles();
+}
+
+bool isCancelled()
+{
+	return gIsCancelled.load(std::memory_order_relaxed);
 }
 
 const StaticConfig &getStaticConfig(const RunConfig &config)
@@ -30,6 +51,19 @@ const StaticConfig &getStaticConfig(const RunConfig &config)
 	return RunConfig::getStaticConfig(path);
 }
 
+// Static config is loaded before targets are collected, so its error ends the run with a code,
+// instead of an exception, that would terminate the application and lose queued log messages.
+bool loadStaticConfig(const RunConfig &config)
+{
+	try {
+		const auto &staticConfig = getStaticConfig(config);
+		Q_UNUSED(staticConfig)
+	} catch (const std::exception &) {
+		return false;
+	}
+	return true;
+}
+
 constexpr bool isExtensionExcluded(const QString &path)
 {
 	using namespace appconst;
@@ -48,17 +82,161 @@ bool isPathExcluded(const QString &path, const ExcludedPathSections &excluded)
 	    || isExtensionExcluded(path);
 }
 
-bool processFile(Context ctx)
+// Huge files are not loaded completely: only the head, where the header may be, is read, and the
+// rest of the file is copied by the kernel, if it is replaced.
+bool shouldStreamFile(const Context &ctx)
+{
+#ifdef Q_OS_WIN
+	// Files are read in text mode, so content offsets differ from the file offsets.
+	Q_UNUSED(ctx)
+	return false;
+#else
+	return ctx.config.maxHeaderOffset() > 0
+	    && QFileInfo(ctx.targetPath).size() >= appconst::cStreamingFileSize;
+#endif
+}
+
+// Header may start anywhere within the maximum header offset, so the head of a streamed file covers
+// a header of limited size after it.
+qint64 streamedHeadSize(const RunConfig &config)
+{
+	return config.maxHeaderOffset() + appconst::cMaxStreamedHeaderSize;
+}
+
+// Targets are repositories, which files are listed by git, with --rev and --staged.
+bool listsRepositoryFiles(const RunConfig &config)
+{
+	const auto &options = config.options();
+	return options.testFlag(RunOption::RevisionMode) || options.testFlag(RunOption::StagedMode);
+}
+
+// Files are read from blobs with --rev and --staged, and with --commit-to, so only committed
+// content gets to the new commit.
+bool readsBlobs(const RunConfig &config)
+{
+	return listsRepositoryFiles(config) || !config.commitRef().isEmpty();
+}
+
+// Assigns time passed since previous lap to the stage, that has just finished.
+struct StageTimer
+{
+	explicit StageTimer(FileReport &report)
+	    : m_report(report)
+	    , m_lapStartNsecs(profiler::nowNsecs())
+	{}
+
+	void lap(FileReport::Stage stage)
+	{
+		const auto nowNsecs = profiler::nowNsecs();
+		m_report.stageNsecs[stage] += nowNsecs - m_lapStartNsecs;
+		profiler::traceSpan(profiler::toStage(stage), m_lapStartNsecs, nowNsecs);
+		m_lapStartNsecs = nowNsecs;
+	}
+
+	// Time since the last lap is not assigned to any stage.
+	void restart() { m_lapStartNsecs = profiler::nowNsecs(); }
+
+private:
+	FileReport &m_report;
+	qint64 m_lapStartNsecs;
+};
+
+// Gets output of 'git blame' without blocking the thread.
+struct BlameOutputAwaiter
+{
+	const QString &repoRoot;
+	const QString &filePath;
+	const QString &revision;
+	// Is blamed instead of the file of 'revision', if it is set.
+	const QByteArray *content;
+	std::optional<QByteArray> output;
+
+	[[nodiscard]] bool await_ready() const noexcept { return false; }
+
+	void await_suspend(std::coroutine_handle<> handle)
+	{
+		// The coroutine may be resumed before this function returns, so 'this' is not used after.
+		auto onFinished = [this, handle](std::optional<QByteArray> result) {
+			output = std::move(result);
+			concurrency::resume(handle);
+		};
+		if (content) {
+			git_helpers::blameContentAsync(repoRoot, filePath, *content, std::move(onFinished));
+		} else {
+			git_helpers::blameFileAsync(repoRoot, filePath, revision, std::move(onFinished));
+		}
+	}
+
+	std::optional<QByteArray> await_resume() { return std::move(output); }
+};
+
+using FileCallback = std::function<void(FileReport report, FileOutput output, bool isUpdated)>;
+
+// Header and the rest of the content are written to a single pre-sized buffer.
+QByteArray serializeFile(const Header &header)
+{
+	const auto contentData = header.contentWithoutHeader();
+	const auto headerSize = static_cast<int>(header.serializedSize());
+	QByteArray fileData(headerSize + contentData.size(), Qt::Uninitialized);
+	auto *contentStart = header.serialize(fileData.data());
+	std::copy(contentData.cbegin(), contentData.cend(), contentStart);
+	return fileData;
+}
+
+// Coroutine of one file. It is suspended only while it waits for a git slot and for blame, so
+// pool threads are not blocked by git, and many files may wait for git at once.
+// 'prefetched' has content, if the file was read in a batch.
+concurrency::Task processFile(Context ctx, FileReport report, file_utils::FileRead prefetched,
+                              FileCallback onProcessed)
 {
+	using Action = FileReport::Action;
+
+	const auto startNsecs = profiler::nowNsecs();
+	// Spans are recorded per thread, so the file span is split at the suspension.
+	auto spanStartNsecs = startNsecs;
+	FileOutput output;
+	const auto finish = [&](Action action, bool isUpdated) {
+		const auto endNsecs = profiler::nowNsecs();
+		profiler::traceSpan(profiler::File, spanStartNsecs, endNsecs, report.path);
+		report.action = action;
+		report.totalNsecs = endNsecs - startNsecs;
+		onProcessed(std::move(report), std::move(output), isUpdated);
+	};
+
+	if (isCancelled()) {
+		finish(Action::Skipped, false);
+		co_return;
+	}
+
 	try {
 		GitRepository repo(ctx.targetRepoRootPath);
 		repo.open();
 
 		CN_INF(Msg::ProcessingFile, "Processing file " << ctx.targetPath << '.');
 
-		const auto content = file_utils::readFile(ctx.targetPath);
+		if (!prefetched.content && readsBlobs(ctx.config)) {
+			// There is no file to read, the error is logged, when the blob is read.
+			throw std::exception();
+		}
+
+		StageTimer timer(report);
+		const bool isStreamed = prefetched.content ? prefetched.isHead : shouldStreamFile(ctx);
+		const auto content = prefetched.content ? std::move(*prefetched.content)
+		    : isStreamed ? file_utils::readFileHead(ctx.targetPath, streamedHeadSize(ctx.config))
+		                 : file_utils::readFile(ctx.targetPath);
+		timer.lap(FileReport::Read);
+
 		Header header(ctx, content, std::move(repo));
 		header.load();
+		timer.lap(FileReport::Load);
+
+		if (isStreamed && header.isUnterminated()) {
+			// The old header would stay after the new one, so the file is not changed.
+			CN_ERR(Msg::BadHeaderFormat,
+			       "Header of " << ctx.targetPath << " does not end within first "
+			                    << content.size() << " bytes.");
+			throw std::exception();
+		}
 
 		if (!header.isEmpty()) {
 			try {
@@ -70,27 +248,128 @@ bool processFile(Context ctx)
 		} else {
 			CN_DEBUG("Header not found in " << ctx.targetPath << '.');
 		}
+		timer.lap(FileReport::Parse);
 
-		if (!header.fix()) {
+		if (isCancelled()) {
+			finish(Action::Skipped, false);
+			co_return;
+		}
+
+		header.fixFields();
+		timer.lap(FileReport::Fix);
+
+		if (header.needsBlame()) {
+			profiler::traceSpan(profiler::File, spanStartNsecs, profiler::nowNsecs(), report.path);
+
+			co_await concurrency::acquireGitSlot();
+			concurrency::GitSlotGuard gitSlot;
+			const auto blameStartNsecs = profiler::nowNsecs();
+			// Staged content is blamed, the file of HEAD may differ from it or not exist.
+			const bool isStaged = ctx.config.options().testFlag(RunOption::StagedMode);
+			const auto blameOutput = co_await BlameOutputAwaiter{
+			    ctx.targetRepoRootPath, ctx.targetPath, ctx.config.revision(),
+			    isStaged ? &content : nullptr, {}};
+			gitSlot.release();
+			if (!blameOutput.has_value()) {
+				throw std::exception();
+			}
+
+			// Only parsing is traced here, the process itself is traced by the git thread.
+			spanStartNsecs = profiler::nowNsecs();
+			auto blame = git_helpers::parseBlame(blameOutput.value());
+			const auto blameEndNsecs = profiler::nowNsecs();
+			profiler::traceSpan(profiler::Blame, spanStartNsecs, blameEndNsecs);
+			header.setBlame(std::move(blame), blameEndNsecs - blameStartNsecs);
+			timer.restart();
+		}
+
+		const bool needsUpdate = header.fixAuthors();
+		timer.lap(FileReport::Fix);
+
+		const auto &stats = header.stats();
+		report.changedFields = stats.changedFields;
+		report.authorShares = stats.authorShares;
+		report.blameLineCount = stats.blameLineCount;
+		report.stageNsecs[FileReport::Blame] = stats.blameNsecs;
+
+		if (!needsUpdate) {
 			CN_DEBUG("Header in file" << ctx.targetPath << "will not be updated.");
-			return false;
+			finish(Action::Unchanged, false);
+			co_return;
 		}
 
 		CN_DEBUG("Header in file" << ctx.targetPath << "needs to be updated.");
 
-		const auto headerData = header.serialize();
+		if (!ctx.config.patchPath().isEmpty()) {
+			// Only heads and blobs are read with carriage returns.
+			const bool isCrLf = !isStreamed && !readsBlobs(ctx.config)
+			    && file_utils::hasCrLfLineEnds(ctx.targetPath);
+			output.diff = patch_helpers::makeFileDiff(report.path, content,
+			                                          header.headerEndOffset(), header.serialize(),
+			                                          !isStreamed, isCrLf ? "\r\n" : "\n");
+			timer.lap(FileReport::Serialize);
+		}
+
+		if (ctx.config.options() & RunOption::CheckMode) {
+			CN_INF(Msg::OutdatedCopyrightNotice,
+			       "Copyright Notice in file " << ctx.targetPath << " is outdated.");
+			finish(Action::WouldUpdate, true);
+			co_return;
+		}
 
 		if (ctx.config.options() & RunOption::ReadOnlyMode) {
-			// clang-format off
-			CN_INF(Msg::WouldUpdateCopyrightNotice,
-					"Would update Copyright Notice in file " << ctx.targetPath
-					<< " with the following:\n" << headerData);
-			// clang-format on
-			return false;
+			if (ctx.config.patchPath().isEmpty()) {
+				const auto headerData = header.serialize();
+				timer.lap(FileReport::Serialize);
+				// clang-format off
+				CN_INF(Msg::WouldUpdateCopyrightNotice,
+						"Would update Copyright Notice in file " << ctx.targetPath
+						<< " with the following:\n" << headerData);
+				// clang-format on
+			}
+			finish(Action::WouldUpdate, false);
+			co_return;
 		}
 
-		const auto contentData = header.contentWithoutHeader();
-		file_utils::writeFile(ctx.targetPath, headerData + contentData);
+		const auto headSize = static_cast<qint64>(header.headerEndOffset());
+		if (!ctx.config.commitRef().isEmpty()) {
+			// Updated content is committed, the file itself is not changed. Content is read from
+			// the blob of the base revision, so the whole file is loaded.
+			const auto fileData = serializeFile(header);
+			timer.lap(FileReport::Serialize);
+
+			GitRepository commitRepo(ctx.targetRepoRootPath);
+			commitRepo.open();
+			output.blobId = commitRepo.writeBlob(fileData);
+			output.repoRoot = ctx.targetRepoRootPath;
+			output.repoFilePath = QDir(ctx.targetRepoRootPath).relativeFilePath(ctx.targetPath);
+			timer.lap(FileReport::Write);
+		} else if (ctx.config.options().testFlag(RunOption::StagedMode)) {
+			// Content is read from the index, so it is written there, and the file is updated after
+			// the index, only if it has no unstaged changes, which is checked by IndexWriter.
+			auto fileData = serializeFile(header);
+			timer.lap(FileReport::Serialize);
+
+			GitRepository stageRepo(ctx.targetRepoRootPath);
+			stageRepo.open();
+			output.blobId = stageRepo.writeBlob(fileData);
+			output.repoRoot = ctx.targetRepoRootPath;
+			output.repoFilePath = ctx.targetPath;
+			output.fileData = std::move(fileData);
+			timer.lap(FileReport::Write);
+		} else if (isStreamed) {
+			const auto headerData = header.serialize();
+			timer.lap(FileReport::Serialize);
+
+			file_utils::replaceFileHead(ctx.targetPath, headSize, headerData);
+			timer.lap(FileReport::Write);
+		} else {
+			const auto fileData = serializeFile(header);
+			timer.lap(FileReport::Serialize);
+
+			file_utils::writeFile(ctx.targetPath, fileData);
+			timer.lap(FileReport::Write);
+		}
 
 		CN_INF(Msg::UpdatedCopyrightNotice,
 		       "Updated Copyright Notice in file: " << ctx.targetPath << '.');
@@ -98,86 +377,511 @@ bool processFile(Context ctx)
 	} catch (const std::exception &ex) {
 		CN_ERR(Msg::InternalError,
 		       "Cannot process file " << ctx.targetPath << ": " << ex.what() << '.');
-		return false;
+		finish(Action::Error, false);
+		co_return;
 	}
 
-	return true;
+	finish(Action::Updated, true);
 }
 
 }  // namespace
 
-void FileProcessor::process()
+int FileProcessor::process()
+{
+	// Files may have been cancelled by a previous run in the same process.
+	gIsCancelled.store(false, std::memory_order_relaxed);
+	loadShardCosts();
+	openReport();
+
+	concurrency::init(m_config.jobs(), m_config.gitJobs(),
+	                  m_config.options().testFlag(RunOption::AdaptiveGitJobs));
+
+	// Files of all targets are processed by one pool, so small targets are processed in parallel.
+	if (!loadStaticConfig(m_config)) {
+		closeReport(apperror::RunArgError);
+		return apperror::RunArgError;
+	}
+
+	FileSet files;
+	// Requested files would not be processed, so the run would have no result.
+	int exitCode = collectTargets(files) ? processFiles(std::move(files)) : apperror::GitError;
+	if (exitCode == apperror::Success && isAnyFileUpdated()) {
+		exitCode = apperror::FilesChanged;
+	}
+
+	closeReport(exitCode);
+	return exitCode;
+}
+
+bool FileProcessor::collectTargets(FileSet &files)
 {
+	RepoResolver repoResolver;
 	for (const auto &path : m_config.targetPaths()) {
 		if (!QFileInfo::exists(path)) {
 			CN_WARN(Msg::FileOrDirIsNotExist, "Skip not existed target " << path);
 			continue;
 		}
 
-		process(path);
+		if (!listsRepositoryFiles(m_config)) {
+			collectFiles(path, repoResolver, files);
+		} else if (!collectRepositoryFiles(path, files)) {
+			return false;
+		}
 	}
+	qualifyRelativePaths(files);
+
+	// Files would be committed with their uncommitted changes otherwise.
+	return !readsBlobs(m_config) || listsRepositoryFiles(m_config) || collectBaseBlobs(files);
 }
 
-void FileProcessor::process(const QString &targetPath)
+void FileProcessor::collectFiles(const QString &targetPath, RepoResolver &repoResolver,
+                                 FileSet &files)
 {
-	QString gitRepoRoot;
+	const auto &staticConfig = getStaticConfig(m_config);
 
-	try {
-		gitRepoRoot = GitRepository::getWorkingTreeDir(targetPath);
-		CN_DEBUG("Using repository" << gitRepoRoot);
-	} catch (const std::exception &ex) {
-		CN_ERR(Msg::BadTargetPaths,
-		       "Cannot process file or dir " << targetPath << " : " << ex.what() << '.');
+	const auto addFile = [&](const QString &filePath) {
+		if (isPathExcluded(filePath, staticConfig.excludedPathSections())) {
+			CN_DEBUG("Skip excluded file" << filePath);
+			return;
+		}
+
+		const QFileInfo fileInfo(filePath);
+		auto absolutePath = fileInfo.absoluteFilePath();
+		auto location = repoResolver.locate(absolutePath);
+		if (location.repoRoot.isEmpty()) {
+			CN_WARN(Msg::FileOutsideOfRepository,
+			        "Skip file " << filePath << " that is outside of any repository");
+			return;
+		}
+
+		if (!files.canonicalPaths.insert(fileInfo.canonicalFilePath()).second) {
+			CN_DEBUG("Skip file" << filePath << "that is already added by another target");
+			return;
+		}
+
+		files.filePaths.emplace_back(std::move(absolutePath));
+		files.relativePaths.emplace_back(std::move(location.relativePath));
+		files.repoRoots.emplace_back(std::move(location.repoRoot));
+		files.topRoots.emplace_back(std::move(location.topRoot));
+	};
+
+	if (QFileInfo(targetPath).isFile()) {
+		addFile(targetPath);
 		return;
 	}
 
-	const QFileInfo target(targetPath);
+	// Files of submodules and nested repositories are collected too, each gets its own repository.
+	QDirIterator it(targetPath, QDir::Files | QDir::NoSymLinks, QDirIterator::Subdirectories);
+	while (it.hasNext()) {
+		addFile(it.next());
+	}
+}
+
+bool FileProcessor::collectRepositoryFiles(const QString &repoPath, FileSet &files)
+{
 	const auto &staticConfig = getStaticConfig(m_config);
+	const bool isStaged = m_config.options().testFlag(RunOption::StagedMode);
 
-	if (target.isFile()) {
-		if (!targetPath.contains(gitRepoRoot)) {
-			CN_WARN(Msg::FileOutsideOfRepository,
-			        "Skip file " << targetPath << "that is outside of repo " << gitRepoRoot);
-			return;
+	QString repoRoot;
+	std::vector<GitRepository::TreeFile> treeFiles;
+	try {
+		GitRepository repo(QFileInfo(repoPath).absoluteFilePath());
+		repo.open();
+		repoRoot = repo.getWorkingTreeDir();
+		// Index is read once, and only files of the next commit are processed.
+		treeFiles = isStaged ? repo.listStagedFiles() : repo.listFiles(m_config.revision());
+	} catch (const std::exception &) {
+		const auto listed = isStaged ? QStringLiteral("Staged files")
+		                             : QStringLiteral("Files of ") + m_config.revision();
+		CN_ERR(Msg::BadRevision, listed << " in repository " << repoPath << " can not be listed.");
+		return false;
+	}
+
+	for (auto &file : treeFiles) {
+		if (isPathExcluded(file.path, staticConfig.excludedPathSections())) {
+			CN_DEBUG("Skip excluded file" << file.path);
+			continue;
 		}
 
-		if (isPathExcluded(targetPath, staticConfig.excludedPathSections())) {
-			CN_DEBUG("Skip excluded file" << targetPath);
-			return;
+		if (!files.canonicalPaths.insert(QString(repoRoot % '/' % file.path)).second) {
+			CN_DEBUG("Skip file" << file.path << "that is already added by another target");
+			continue;
 		}
 
-		processFile({targetPath, std::move(gitRepoRoot), m_config});
+		// Paths stay relative to the repository, blame is run there, and there may be no working
+		// tree, that absolute paths would point to.
+		files.filePaths.emplace_back(file.path);
+		files.relativePaths.emplace_back(std::move(file.path));
+		files.repoRoots.emplace_back(repoRoot);
+		files.topRoots.emplace_back(repoRoot);
+		files.blobIds.emplace_back(std::move(file.blobId));
+	}
+	return true;
+}
+
+bool FileProcessor::collectBaseBlobs(FileSet &files)
+{
+	// Blobs of the base tree of every repository by paths relative to it.
+	std::map<QString, GitRepository::BlobIds> repoBlobIds;
+	FileSet baseFiles;
+	for (std::size_t i = 0; i < files.filePaths.size(); i++) {
+		const auto &repoRoot = files.repoRoots[i];
+		auto repoIt = repoBlobIds.find(repoRoot);
+		if (repoIt == repoBlobIds.end()) {
+			GitRepository::BlobIds blobIds;
+			try {
+				GitRepository repo(repoRoot);
+				repo.open();
+				for (auto &file : repo.listFiles(m_config.revision())) {
+					blobIds.emplace(std::move(file.path), std::move(file.blobId));
+				}
+			} catch (const std::exception &) {
+				CN_ERR(Msg::BadRevision, "Files of " << m_config.revision() << " in repository "
+				                                     << repoRoot << " can not be listed.");
+				return false;
+			}
+			repoIt = repoBlobIds.emplace(repoRoot, std::move(blobIds)).first;
+		}
+
+		const auto repoFilePath = QDir(repoRoot).relativeFilePath(files.filePaths[i]);
+		const auto blobIt = repoIt->second.find(repoFilePath);
+		if (blobIt == repoIt->second.cend()) {
+			CN_DEBUG("Skip file" << files.filePaths[i] << "that is not in" << m_config.revision());
+			continue;
+		}
+
+		baseFiles.filePaths.emplace_back(std::move(files.filePaths[i]));
+		baseFiles.relativePaths.emplace_back(std::move(files.relativePaths[i]));
+		baseFiles.repoRoots.emplace_back(repoRoot);
+		baseFiles.topRoots.emplace_back(std::move(files.topRoots[i]));
+		baseFiles.blobIds.emplace_back(blobIt->second);
+	}
+
+	baseFiles.canonicalPaths = std::move(files.canonicalPaths);
+	files = std::move(baseFiles);
+	return true;
+}
+
+void FileProcessor::qualifyRelativePaths(FileSet &files)
+{
+	const std::set<QString> topRoots(files.topRoots.cbegin(), files.topRoots.cend());
+	if (topRoots.size() <= 1) {
 		return;
 	}
 
+	const auto contains = [](const QString &dirPath, const QString &path) {
+		const auto prefix = dirPath.endsWith('/') ? dirPath : QString(dirPath + '/');
+		return path == dirPath || path.startsWith(prefix);
+	};
+	auto parentPath = *topRoots.cbegin();
+	while (!std::all_of(topRoots.cbegin(), topRoots.cend(),
+	                    [&](const auto &root) { return contains(parentPath, root); })) {
+		auto nextParentPath = QFileInfo(parentPath).path();
+		if (nextParentPath == parentPath) {
+			break;  // Working trees are on different drives.
+		}
+		parentPath = std::move(nextParentPath);
+	}
+
+	const QDir parentDir(parentPath);
+	for (std::size_t i = 0; i < files.relativePaths.size(); i++) {
+		// Repository of --rev may be the parent itself.
+		const auto rootPath = parentDir.relativeFilePath(files.topRoots[i]);
+		if (!rootPath.isEmpty() && rootPath != ".") {
+			files.relativePaths[i].prepend(rootPath + '/');
+		}
+	}
+	CN_DEBUG("Paths of files are relative to" << parentPath);
+}
+
+int FileProcessor::processFiles(FileSet files)
+{
+	const auto shardFiles = shard_helpers::selectShard(files.relativePaths, m_config.shardIndex(),
+	                                                   m_config.shardCount(), m_shardCosts);
+	CN_DEBUG("Shard contains" << shardFiles.size() << "of" << files.filePaths.size() << "files");
+
 	signal(SIGABRT, onTermination);
 	signal(SIGINT, onTermination);
 	signal(SIGTERM, onTermination);  // *UNIX only
 
-	QDirIterator it(targetPath, QDir::Files | QDir::NoSymLinks, QDirIterator::Subdirectories);
-	while (it.hasNext()) {
-		auto filePath = it.next();
+	if (!openPatch(files, shardFiles)) {
+		// Files are not modified with --emit-patch, so the run would have no result.
+		return apperror::RunArgError;
+	}
 
-		if (!filePath.contains(gitRepoRoot)) {
-			CN_WARN(Msg::FileOutsideOfRepository,
-			        "Skip file or dir " << filePath << " that is outside of repo " << gitRepoRoot);
-			continue;
+	if (!m_config.commitRef().isEmpty()) {
+		m_commitWriter = std::make_unique<CommitWriter>(m_config.commitRef(), m_config.revision());
+	} else if (m_config.options().testFlag(RunOption::StagedMode)) {
+		m_indexWriter = std::make_unique<IndexWriter>();
+	}
+
+	const FileCallback onProcessed = [this](FileReport report, FileOutput output, bool isUpdated) {
+		onFileProcessed(std::move(report), std::move(output), isUpdated);
+		finishFile();
+	};
+
+	std::vector<file_utils::FileRead> reads;
+	qint64 readNsecsPerFile = 0;
+	for (std::size_t i = 0; i < shardFiles.size(); i++) {
+		if (isCancelled()) {
+			break;
 		}
 
-		if (isPathExcluded(filePath, staticConfig.excludedPathSections())) {
-			CN_DEBUG("Skip excluded file or dir" << filePath);
-			continue;
+		const auto index = shardFiles[i];
+		const auto batchIndex = i % cReadBatchSize;
+		if (batchIndex == 0) {
+			readNsecsPerFile = prefetchFiles(files, shardFiles, i, reads);
+		}
+
+		startFile();
+
+		FileReport report;
+		report.path = std::move(files.relativePaths[index]);
+		file_utils::FileRead prefetched;
+		if (!reads.empty()) {
+			// Batch time is shared by its files.
+			report.stageNsecs[FileReport::Read] = readNsecsPerFile;
+			prefetched = std::move(reads[batchIndex]);
+		}
+
+		Context ctx{std::move(files.filePaths[index]), std::move(files.repoRoots[index]), m_config};
+		auto task = [ctx = std::move(ctx), report = std::move(report),
+		             prefetched = std::move(prefetched), onProcessed]() mutable {
+			processFile(std::move(ctx), std::move(report), std::move(prefetched), onProcessed);
+		};
+		concurrency::post(std::move(task));
+	}
+
+	waitForFiles();
+	closePatch();
+	const bool isCommitted = closeCommit();
+	const bool isStaged = closeIndex();
+	// Files are not modified with --commit-to, so the run has no result without the commit, and
+	// updated files would be committed without their new headers without the index.
+	return isCommitted && isStaged ? apperror::Success : apperror::GitError;
+}
+
+qint64 FileProcessor::prefetchFiles(const FileSet &files, const std::vector<std::size_t> &indexes,
+                                   std::size_t first, std::vector<file_utils::FileRead> &reads)
+{
+	reads.clear();
+	const bool areBlobs = !files.blobIds.empty();
+	if (m_isBatchReadUnavailable && !areBlobs) {
+		return 0;
+	}
+
+	const auto last = std::min(first + cReadBatchSize, indexes.size());
+	for (auto i = first; i < last; i++) {
+		auto &read = reads.emplace_back();
+		read.path = files.filePaths[indexes[i]];
+		read.headFileSize = appconst::cStreamingFileSize;
+		read.headSize = streamedHeadSize(m_config);
+	}
+
+	const profiler::ScopedSpan span(profiler::Read, QStringLiteral("batch"));
+	const auto startNsecs = profiler::nowNsecs();
+	if (areBlobs) {
+		readBlobs(files, indexes, first, reads);
+	} else if (!file_utils::readFiles(reads)) {
+		CN_DEBUG("Files are read one by one");
+		m_isBatchReadUnavailable = true;
+		reads.clear();
+		return 0;
+	}
+	return (profiler::nowNsecs() - startNsecs) / static_cast<qint64>(reads.size());
+}
+
+void FileProcessor::readBlobs(const FileSet &files, const std::vector<std::size_t> &indexes,
+                              std::size_t first, std::vector<file_utils::FileRead> &reads)
+{
+	// Blobs of every repository in the batch are read with one request.
+	std::map<QString, std::vector<std::size_t>> repoReads;
+	for (std::size_t i = 0; i < reads.size(); i++) {
+		repoReads[files.repoRoots[indexes[first + i]]].emplace_back(i);
+	}
+
+	for (const auto &[repoRoot, readIndexes] : repoReads) {
+		std::vector<QString> blobIds;
+		blobIds.reserve(readIndexes.size());
+		for (const auto i : readIndexes) {
+			blobIds.emplace_back(files.blobIds[indexes[first + i]]);
 		}
 
-		gThreadPool.start([this, filePath, gitRepoRoot]() mutable {
-			if (processFile({std::move(filePath), std::move(gitRepoRoot), m_config})) {
-				m_isAnyFileUpdated.test_and_set(std::memory_order_relaxed);
+		try {
+			GitRepository repo(repoRoot);
+			repo.open();
+			auto blobs = repo.readBlobs(blobIds);
+			for (std::size_t i = 0; i < readIndexes.size(); i++) {
+				reads[readIndexes[i]].content = std::move(blobs[i]);
 			}
-		});
+		} catch (const std::exception &) {
+			// Files without content are reported as errors, when they are processed.
+			CN_ERR(Msg::FileReadWriteError, "Blobs of repository " << repoRoot << " are not read.");
+		}
+	}
+}
+
+void FileProcessor::startFile()
+{
+	std::unique_lock l(m_filesMutex);
+	m_fileFinished.wait(l, [this] { return m_filesInFlight < concurrency::maxFilesInFlight(); });
+	m_filesInFlight++;
+}
+
+void FileProcessor::finishFile()
+{
+	{
+		std::lock_guard l(m_filesMutex);
+		m_filesInFlight--;
+	}
+	m_fileFinished.notify_all();
+}
+
+void FileProcessor::waitForFiles()
+{
+	std::unique_lock l(m_filesMutex);
+	m_fileFinished.wait(l, [this] { return m_filesInFlight == 0; });
+}
+
+void FileProcessor::onFileProcessed(FileReport report, FileOutput output, bool isUpdated)
+{
+	profiler::recordFile(report);
+
+	if (m_patchWriter) {
+		m_patchWriter->write(report.path, std::move(output.diff));
+	}
+
+	if (m_commitWriter && !output.blobId.isEmpty()) {
+		m_commitWriter->add(output.repoRoot, output.repoFilePath, output.blobId);
+	}
+
+	if (m_indexWriter && !output.blobId.isEmpty()) {
+		m_indexWriter->add(output.repoRoot, output.repoFilePath, output.blobId,
+		                   std::move(output.fileData));
+	}
+
+	if (m_reportWriter) {
+		m_reportWriter->write(std::move(report));
+	}
+
+	if (!isUpdated) {
+		return;
+	}
+
+	m_isAnyFileUpdated.test_and_set(std::memory_order_relaxed);
+
+	const auto &options = m_config.options();
+	if (options.testFlag(RunOption::CheckMode) && !options.testFlag(RunOption::CheckAllMode)) {
+		cancelPendingFiles();
+	}
+}
+
+void FileProcessor::loadShardCosts()
+{
+	const auto &path = m_config.shardCostsPath();
+	if (path.isEmpty()) {
+		return;
+	}
+
+	if (!QFileInfo::exists(path)) {
+		CN_WARN(Msg::BadReport,
+		        "Shard costs " << path << " not found, files will be sharded by path hash.");
+		return;
+	}
+
+	try {
+		m_shardCosts = report_helpers::readFileCosts(path);
+	} catch (const std::exception &) {
+		CN_WARN(Msg::BadReport,
+		        "Shard costs " << path << " are ignored, files will be sharded by path hash.");
+	}
+}
+
+void FileProcessor::openReport()
+{
+	const auto &path = m_config.reportPath();
+	if (path.isEmpty()) {
+		return;
+	}
+
+	try {
+		m_reportWriter = std::make_unique<ReportWriter>(path);
+	} catch (const std::exception &) {
+		CN_ERR(Msg::BadReport, "Report " << path << " will not be written.");
+	}
+}
+
+void FileProcessor::closeReport(int exitCode)
+{
+	if (!m_reportWriter) {
+		return;
 	}
 
-	std::lock_guard l(gThreadPoolMutex);
-	gThreadPool.waitForDone();
+	m_reportWriter->close(m_config.shardIndex(), m_config.shardCount(), exitCode);
+	m_reportWriter.reset();
+}
+
+bool FileProcessor::openPatch(const FileSet &files, const std::vector<std::size_t> &indexes)
+{
+	const auto &path = m_config.patchPath();
+	if (path.isEmpty()) {
+		return true;
+	}
+
+	std::vector<QString> paths;
+	paths.reserve(indexes.size());
+	for (const auto index : indexes) {
+		paths.emplace_back(files.relativePaths[index]);
+	}
+
+	try {
+		m_patchWriter = std::make_unique<PatchWriter>(path, std::move(paths));
+	} catch (const std::exception &) {
+		return false;
+	}
+	return true;
+}
+
+void FileProcessor::closePatch()
+{
+	if (!m_patchWriter) {
+		return;
+	}
+
+	m_patchWriter->close();
+	m_patchWriter.reset();
+}
+
+bool FileProcessor::closeCommit()
+{
+	if (!m_commitWriter) {
+		return true;
+	}
+
+	bool isCommitted = true;
+	try {
+		m_commitWriter->close();
+	} catch (const std::exception &) {
+		isCommitted = false;
+	}
+	m_commitWriter.reset();
+	return isCommitted;
+}
+
+bool FileProcessor::closeIndex()
+{
+	if (!m_indexWriter) {
+		return true;
+	}
+
+	bool isStaged = true;
+	try {
+		m_indexWriter->close();
+	} catch (const std::exception &) {
+		isStaged = false;
+	}
+	m_indexWriter.reset();
+	return isStaged;
 }
 
 bool FileProcessor::isAnyFileUpdated()
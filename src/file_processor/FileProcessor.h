@@ -1,11 +1,36 @@
 #pragma once
 
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+
 #include "Context.h"
+#include "src/file_processor/git/CommitWriter.h"
 #include "src/file_processor/git/GitRepository.h"
+#include "src/file_processor/git/IndexWriter.h"
+#include "src/file_processor/git/RepoResolver.h"
+#include "src/file_processor/patch/PatchWriter.h"
+#include "src/file_processor/report/ReportWriter.h"
+#include "src/file_processor/shard/shard_helpers.h"
+#include "src/file_utils/file_utils.h"
+
+// Results of a file, that are written by FileProcessor instead of the file itself.
+struct FileOutput
+{
+	QByteArray diff;  // With --emit-patch, if the file would be updated.
+	// With --commit-to or --staged: new blob of the file, that is written to its repository.
+	QString blobId;
+	QString repoRoot;
+	QString repoFilePath;
+	// With --staged: new content of the file in the working tree, that is written after the index,
+	// if the file has no unstaged changes.
+	QByteArray fileData;
+};
 
 struct FileProcessor
 {
-	constexpr explicit FileProcessor(const RunConfig &config) noexcept
+	explicit FileProcessor(const RunConfig &config) noexcept
 	    : m_config(config)
 	{
 		static_assert(std::is_move_constructible_v<Context>);
@@ -13,11 +38,75 @@ struct FileProcessor
 		static_assert(std::is_move_constructible_v<GitRepository>);
 	}
 
-	void process();
-	void process(const QString &targetPath);
+	// Returns exit code of the run.
+	[[nodiscard]] int process();
 	[[nodiscard]] bool isAnyFileUpdated();
 
+private:
+	// Files of all targets. Every file is added once, even if targets overlap.
+	struct FileSet
+	{
+		std::vector<QString> filePaths;
+		std::vector<QString> relativePaths;
+		std::vector<QString> repoRoots;  // Owning repository of every file.
+		// Working tree, that every relative path is relative to before qualifyRelativePaths().
+		std::vector<QString> topRoots;
+		// With --rev, --staged or --commit-to: blob of every file, that is read instead of it.
+		// With --rev or --staged paths of such files are relative to their repository.
+		std::vector<QString> blobIds;
+		std::unordered_set<QString> canonicalPaths;
+	};
+
+	// Returns false, if files of any target can not be listed by git.
+	[[nodiscard]] bool collectTargets(FileSet &files);
+	void collectFiles(const QString &targetPath, RepoResolver &repoResolver, FileSet &files);
+	// Collects files of the tree of --rev or staged files of the repository, contents of which are
+	// read from their blobs, so the repository may have no working tree. Returns false, if the
+	// files can not be listed.
+	[[nodiscard]] bool collectRepositoryFiles(const QString &repoPath, FileSet &files);
+	// With --commit-to: assigns blobs of the base revision to files of the working tree, so neither
+	// uncommitted changes nor untracked files are committed. Files, that are not in the base tree,
+	// are skipped. Returns false, if the tree of any repository can not be listed.
+	[[nodiscard]] bool collectBaseBlobs(FileSet &files);
+	// Relative paths key patches, reports and shard costs, but files of unrelated working trees may
+	// have equal ones. If files are of several working trees, their paths are prefixed with the
+	// working tree relative to the common parent directory of all of them.
+	static void qualifyRelativePaths(FileSet &files);
+	[[nodiscard]] int processFiles(FileSet files);
+	// Reads the batch of files, that starts at 'first', at once. Returns read time per file or
+	// leaves 'reads' empty, if files have to be read one by one.
+	qint64 prefetchFiles(const FileSet &files, const std::vector<std::size_t> &indexes,
+	                     std::size_t first, std::vector<file_utils::FileRead> &reads);
+	void readBlobs(const FileSet &files, const std::vector<std::size_t> &indexes, std::size_t first,
+	               std::vector<file_utils::FileRead> &reads);
+	// Suspended files keep their content, so the number of started, but not finished files is
+	// limited.
+	void startFile();
+	void finishFile();
+	void waitForFiles();
+	void onFileProcessed(FileReport report, FileOutput output, bool isUpdated);
+	void loadShardCosts();
+	void openReport();
+	void closeReport(int exitCode);
+	[[nodiscard]] bool openPatch(const FileSet &files, const std::vector<std::size_t> &indexes);
+	void closePatch();
+	// Returns false, if the commit is not written.
+	[[nodiscard]] bool closeCommit();
+	// Returns false, if the index is not written.
+	[[nodiscard]] bool closeIndex();
+
 private:
 	const RunConfig &m_config;
 	std::atomic_flag m_isAnyFileUpdated = ATOMIC_FLAG_INIT;
+
+	std::mutex m_filesMutex;
+	std::condition_variable m_fileFinished;
+	int m_filesInFlight = 0;
+	bool m_isBatchReadUnavailable = false;
+
+	shard_helpers::FileCosts m_shardCosts;
+	std::unique_ptr<ReportWriter> m_reportWriter;
+	std::unique_ptr<PatchWriter> m_patchWriter;
+	std::unique_ptr<CommitWriter> m_commitWriter;
+	std::unique_ptr<IndexWriter> m_indexWriter;
 };
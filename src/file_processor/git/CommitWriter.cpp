@@ -0,0 +1,36 @@
+#include "CommitWriter.h"
+
+#include "src/logger/log.h"
+
+namespace {
+
+const QLatin1String cCommitMessage("Update copyright notices");
+
+}  // namespace
+
+CommitWriter::CommitWriter(QString ref, QString baseRev)
+    : m_ref(std::move(ref))
+    , m_baseRev(std::move(baseRev))
+{}
+
+void CommitWriter::add(const QString &repoRoot, const QString &repoFilePath,
+                       const QString &blobId)
+{
+	std::lock_guard l(m_mutex);
+	m_repoBlobs[repoRoot].emplace(repoFilePath, blobId);
+}
+
+void CommitWriter::close()
+{
+	std::lock_guard l(m_mutex);
+
+	for (const auto &[repoRoot, blobs] : m_repoBlobs) {
+		GitRepository repo(repoRoot);
+		repo.open();
+		const auto commit = repo.commitBlobs(m_baseRev, blobs, m_ref, cCommitMessage);
+		CN_INF(logger::MsgCode::CommittedFiles,
+		       "Committed " << blobs.size() << " files to " << m_ref << " in " << repoRoot << ": "
+		                    << commit << '.');
+	}
+	m_repoBlobs.clear();
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <QString>
+#include <map>
+#include <mutex>
+
+#include "GitRepository.h"
+
+// Collects blobs of updated files and commits them to the ref of every repository, that has
+// updated files, so neither working trees nor indexes are changed.
+struct CommitWriter
+{
+	CommitWriter(QString ref, QString baseRev);
+	CommitWriter(const CommitWriter &) = delete;
+
+	// 'repoFilePath' is relative to 'repoRoot', 'blobId' is already written to its repository.
+	void add(const QString &repoRoot, const QString &repoFilePath, const QString &blobId);
+
+	// Commits blobs of every repository on top of the base revision and moves the ref to it.
+	void close();
+
+private:
+	const QString m_ref;
+	const QString m_baseRev;
+	std::mutex m_mutex;
+	std::map<QString, GitRepository::BlobIds> m_repoBlobs;
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <QString>
+#include <vector>
+
+// Blamed lines refer to commits and commits refer to authors by dense ids, so statistic is
+// collected without hashing strings for every line.
+struct GitBlame
+{
+	using Id = std::uint32_t;
+
+	// Commit of lines, that are not committed yet, if content is blamed instead of a revision.
+	static inline const QLatin1String cUncommittedHash{"0000000000000000000000000000000000000000"};
+
+	std::vector<QString> commits;   // Distinct commit hashes, indexed by commit id.
+	std::vector<Id> commitAuthors;  // Author id of every commit, indexed by commit id.
+	std::vector<QString> authors;   // Distinct author names, indexed by author id.
+	std::vector<Id> lines;          // Commit id of every blamed line.
+};
@@ -1,9 +0,0 @@
-#pragma once
-
-#include <QString>
-
-struct GitBlameLine
-{
-	QString hash;
-	QString author;
-};
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "IndexWriter.h"
+
+#include <QDir>
+
+#include "git_helpers.h"
+#include "src/file_utils/file_utils.h"
+#include "src/logger/log.h"
+
+namespace {
+
+// Drops files, that differ from their staged blobs, so their unstaged changes are not lost. Files
+// are compared by git, so line endings are converted like on staging. Must be called before the
+// index is changed, changes, that are made after the call, are still overwritten.
+void dropUnstagedFiles(const QString &repoRoot, std::map<QString, QByteArray> &repoFileData)
+{
+	QByteArray unstagedPaths;
+	try {
+		unstagedPaths = git_helpers::runGitTool({"diff", "--name-only", "-z"}, repoRoot);
+	} catch (const std::exception &) {
+		// The error is logged, files can not be checked, so none of them is written.
+		repoFileData.clear();
+		return;
+	}
+
+	for (const auto &path : unstagedPaths.split('\0')) {
+		const auto itr = repoFileData.find(QString::fromUtf8(path));
+		if (itr == repoFileData.end()) {
+			continue;
+		}
+
+		CN_WARN(logger::MsgCode::UnstagedChanges,
+		        "File " << QDir(repoRoot).filePath(itr->first)
+		                << " has unstaged changes, only the index is updated.");
+		repoFileData.erase(itr);
+	}
+}
+
+}  // namespace
+
+void IndexWriter::add(const QString &repoRoot, const QString &repoFilePath, const QString &blobId,
+                      QByteArray fileData)
+{
+	std::lock_guard l(m_mutex);
+	m_repoBlobs[repoRoot].emplace(repoFilePath, blobId);
+	if (!fileData.isEmpty()) {
+		m_repoFileData[repoRoot].emplace(repoFilePath, std::move(fileData));
+	}
+}
+
+void IndexWriter::close()
+{
+	std::lock_guard l(m_mutex);
+
+	for (const auto &[repoRoot, blobs] : m_repoBlobs) {
+		auto &repoFileData = m_repoFileData[repoRoot];
+		if (!repoFileData.empty()) {
+			dropUnstagedFiles(repoRoot, repoFileData);
+		}
+
+		GitRepository repo(repoRoot);
+		repo.open();
+		repo.stageBlobs(blobs);
+		CN_INF(logger::MsgCode::StagedFiles,
+		       "Staged " << blobs.size() << " updated files in " << repoRoot << '.');
+
+		const QDir repoDir(repoRoot);
+		for (const auto &[repoFilePath, fileData] : repoFileData) {
+			try {
+				file_utils::writeFile(repoDir.filePath(repoFilePath), fileData);
+			} catch (const std::exception &) {
+				// The error is logged, the file keeps its content, and the index has the new one.
+			}
+		}
+	}
+	m_repoBlobs.clear();
+	m_repoFileData.clear();
+}
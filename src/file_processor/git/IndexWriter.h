@@ -0,0 +1,32 @@
+#pragma once
+
+#include <QString>
+#include <map>
+#include <mutex>
+
+#include "GitRepository.h"
+
+// Collects blobs of updated staged files and writes them to the index of every repository, that
+// has updated files, once all files are processed. Files of the working tree are updated only after
+// the index, so an interrupted run does not leave updated files unstaged.
+struct IndexWriter
+{
+	IndexWriter() = default;
+	IndexWriter(const IndexWriter &) = delete;
+
+	// 'repoFilePath' is relative to 'repoRoot', 'blobId' is already written to its repository.
+	// 'fileData' replaces the file in the working tree, if it is not empty and the file has no
+	// unstaged changes.
+	void add(const QString &repoRoot, const QString &repoFilePath, const QString &blobId,
+	         QByteArray fileData);
+
+	// Replaces staged blobs of the files in the index of every repository, and then the files,
+	// that do not differ from their old staged blobs.
+	void close();
+
+private:
+	std::mutex m_mutex;
+	std::map<QString, GitRepository::BlobIds> m_repoBlobs;
+	// Paths relative to the repository and new contents of files in the working tree.
+	std::map<QString, std::map<QString, QByteArray>> m_repoFileData;
+};
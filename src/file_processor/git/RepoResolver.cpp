@@ -0,0 +1,85 @@
+#include "RepoResolver.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <vector>
+
+#include "src/profiler/profiler.h"
+
+namespace {
+
+// Directory in ordinary repositories and file in submodules and linked worktrees.
+const QLatin1String cGitEntry("/.git");
+
+// Returns the same path for the file system root.
+QString parentDir(const QString &dirPath)
+{
+	return QFileInfo(dirPath).path();
+}
+
+}  // namespace
+
+RepoResolver::Location RepoResolver::locate(const QString &absoluteFilePath)
+{
+	Location location;
+	location.repoRoot = dirRoot(QFileInfo(absoluteFilePath).path());
+	if (!location.repoRoot.isEmpty()) {
+		location.topRoot = topRoot(location.repoRoot);
+		location.relativePath = QDir(location.topRoot).relativeFilePath(absoluteFilePath);
+	}
+	return location;
+}
+
+QString RepoResolver::dirRoot(const QString &dirPath)
+{
+	if (const auto itr = m_dirRoots.find(dirPath); itr != m_dirRoots.cend()) {
+		return itr->second;
+	}
+
+	const profiler::ScopedTimer timer(profiler::RepoDiscovery);
+
+	// Directories, which are passed on the way up, belong to the same repository.
+	std::vector<QString> visitedDirs;
+	QString root;
+	for (auto dir = dirPath;;) {
+		if (const auto itr = m_dirRoots.find(dir); itr != m_dirRoots.cend()) {
+			root = itr->second;
+			break;
+		}
+
+		visitedDirs.emplace_back(dir);
+		if (QFileInfo::exists(dir + cGitEntry)) {
+			root = dir;
+			break;
+		}
+
+		auto parent = parentDir(dir);
+		if (parent == dir) {
+			break;
+		}
+		dir = std::move(parent);
+	}
+
+	for (auto &dir : visitedDirs) {
+		m_dirRoots.emplace(std::move(dir), root);
+	}
+	return root;
+}
+
+const QString &RepoResolver::topRoot(const QString &repoRoot)
+{
+	if (const auto itr = m_topRoots.find(repoRoot); itr != m_topRoots.cend()) {
+		return itr->second;
+	}
+
+	auto top = repoRoot;
+	for (auto parent = parentDir(top); parent != top; parent = parentDir(top)) {
+		auto enclosingRoot = dirRoot(parent);
+		if (enclosingRoot.isEmpty()) {
+			break;
+		}
+		top = std::move(enclosingRoot);
+	}
+
+	return m_topRoots.emplace(repoRoot, std::move(top)).first->second;
+}
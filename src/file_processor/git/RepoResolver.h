@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QString>
+#include <unordered_map>
+
+// Finds the repository of every file: the nearest enclosing working tree, so files of submodules
+// and nested repositories are processed in their own repositories. Roots are cached per directory,
+// so the file system is checked once per directory.
+struct RepoResolver
+{
+	struct Location
+	{
+		QString repoRoot;  // Empty, if file is outside of any repository.
+		// Outermost working tree, that contains the repository.
+		QString topRoot;
+		// Relative to 'topRoot', so paths of submodule files stay unique.
+		QString relativePath;
+	};
+
+	[[nodiscard]] Location locate(const QString &absoluteFilePath);
+
+private:
+	[[nodiscard]] QString dirRoot(const QString &dirPath);
+	[[nodiscard]] const QString &topRoot(const QString &repoRoot);
+
+private:
+	std::unordered_map<QString, QString> m_dirRoots;
+	std::unordered_map<QString, QString> m_topRoots;
+};
@@ -2,6 +2,7 @@
 
 #include <QFileInfo>
 #include <QRegularExpression>
+#include <QTemporaryDir>
 
 #include "../git_helpers.h"
 #include "src/logger/log.h"
@@ -42,6 +43,49 @@ QString getBrokenCommit(const QString &line)
 	return {};
 }
 
+// Listed paths are relative to the root of the repository. libgit2 finds the root from any of its
+// directories, but here the path itself is the root, so other paths are rejected.
+void checkRepositoryRoot(const QString &path)
+{
+	if (!hlp::runGitTool({"rev-parse", "--show-prefix"}, path).trimmed().isEmpty()) {
+		CN_ERR(logger::MsgCode::BadRevision, "Git. " << path << " is not a root of a repository.");
+		throw std::exception();
+	}
+}
+
+// Returns modes of 'paths' in the index, which is written by 'git ls-files -s -z'.
+std::map<QString, QByteArray> getFileModes(const QByteArray &stagedFiles,
+                                           const GitRepository::BlobIds &paths)
+{
+	std::map<QString, QByteArray> modes;
+	for (const auto &entry : stagedFiles.split('\0')) {
+		// <mode> <id> <stage>\t<path>
+		const auto tab = entry.indexOf('\t');
+		if (tab < 0) {
+			continue;
+		}
+
+		auto path = QString::fromUtf8(entry.mid(tab + 1));
+		if (paths.count(path)) {
+			modes.emplace(std::move(path), entry.left(entry.indexOf(' ')));
+		}
+	}
+	return modes;
+}
+
+// Input of 'git update-index -z --index-info'. New files are added as regular ones.
+QByteArray toIndexInfo(const GitRepository::BlobIds &blobs,
+                       const std::map<QString, QByteArray> &modes)
+{
+	QByteArray indexInfo;
+	for (const auto &[path, blobId] : blobs) {
+		const auto mode = modes.find(path);
+		indexInfo += (mode != modes.cend() ? mode->second : QByteArray("100644")) + ' '
+		    + blobId.toLatin1() + '\t' + path.toUtf8() + '\0';
+	}
+	return indexInfo;
+}
+
 }  // namespace
 
 GitRepository::GitRepository(QString repoPath) noexcept
@@ -62,9 +106,9 @@ QString GitRepository::getWorkingTreeDir() const
 	return m_path;
 }
 
-std::vector<QString> GitRepository::getBrokenCommits() const
+std::vector<QString> GitRepository::getBrokenCommits(const QString &revision) const
 {
-	const auto log = hlp::runGitTool({"log", "HEAD", "--pretty=%H %p %s"}, getWorkingTreeDir());
+	const auto log = hlp::runGitTool({"log", revision, "--pretty=%H %p %s"}, getWorkingTreeDir());
 	const auto tokenizedLog = log.split('\n');
 
 	std::vector<QString> result;
@@ -80,9 +124,125 @@ std::vector<QString> GitRepository::getBrokenCommits() const
 	return result;
 }
 
-std::vector<GitBlameLine> GitRepository::blameFile(const QString &filePath) const
+GitBlame GitRepository::blameFile(const QString &filePath, const QString &revision) const
+{
+	return git_helpers::blameFile(getWorkingTreeDir(), filePath, revision);
+}
+
+std::vector<GitRepository::TreeFile> GitRepository::listFiles(const QString &revision) const
+{
+	checkRepositoryRoot(getWorkingTreeDir());
+	const auto tree = hlp::runGitTool(
+	    {"ls-tree", "-r", "-z", "--full-tree", revision + "^{commit}"}, getWorkingTreeDir());
+
+	std::vector<TreeFile> files;
+	for (const auto &entry : tree.split('\0')) {
+		// <mode> <type> <id>\t<path>
+		const auto tab = entry.indexOf('\t');
+		const auto fields = entry.left(tab).split(' ');
+		if (tab < 0 || fields.size() != 3 || fields[1] != "blob" || fields[0] == "120000") {
+			continue;
+		}
+		files.push_back({QString::fromUtf8(entry.mid(tab + 1)), QString::fromLatin1(fields[2])});
+	}
+	return files;
+}
+
+std::vector<GitRepository::TreeFile> GitRepository::listStagedFiles() const
+{
+	checkRepositoryRoot(getWorkingTreeDir());
+	// Everything in the index is staged, if there is no HEAD yet.
+	const auto diff = hlp::runGitTool(
+	    {"diff", "--cached", "--raw", "-z", "--no-abbrev", "--no-renames", "--diff-filter=AM"},
+	    getWorkingTreeDir());
+
+	std::vector<TreeFile> files;
+	const auto fields = diff.split('\0');
+	for (int i = 0; i + 1 < fields.size(); i += 2) {
+		// :<old mode> <new mode> <old id> <new id> <status>\0<path>\0
+		const auto info = fields[i].split(' ');
+		if (info.size() != 5 || (info[1] != "100644" && info[1] != "100755")) {
+			continue;
+		}
+		files.push_back({QString::fromUtf8(fields[i + 1]), QString::fromLatin1(info[3])});
+	}
+	return files;
+}
+
+std::vector<QByteArray> GitRepository::readBlobs(const std::vector<QString> &blobIds) const
+{
+	if (blobIds.empty()) {
+		return {};
+	}
+
+	QByteArray request;
+	for (const auto &id : blobIds) {
+		request += id.toLatin1() + '\n';
+	}
+	// Batch of large blobs may take longer than other commands.
+	const auto output = hlp::runGitTool({"cat-file", "--batch"}, getWorkingTreeDir(), request, {},
+	                                    appconst::cNoProcessTimeout);
+
+	std::vector<QByteArray> blobs;
+	blobs.reserve(blobIds.size());
+	int offset = 0;
+	for (std::size_t i = 0; i < blobIds.size(); i++) {
+		// <id> blob <size>\n<content>\n, or <id> missing\n
+		const auto lineEnd = output.indexOf('\n', offset);
+		const auto fields = output.mid(offset, lineEnd - offset).split(' ');
+		if (lineEnd < 0 || fields.size() != 3 || fields[1] != "blob") {
+			raiseException(1, "reading blob");
+		}
+
+		const auto size = fields[2].toInt();
+		blobs.emplace_back(output.mid(lineEnd + 1, size));
+		offset = lineEnd + 1 + size + 1;
+	}
+	return blobs;
+}
+
+QString GitRepository::writeBlob(const QByteArray &content) const
+{
+	// Filters are not applied to the standard input.
+	const auto id = hlp::runGitTool({"hash-object", "-w", "--stdin"}, getWorkingTreeDir(), content);
+	return QString::fromLatin1(id.trimmed());
+}
+
+QString GitRepository::commitBlobs(const QString &baseRev, const BlobIds &blobs,
+                                   const QString &ref, const QString &message) const
+{
+	const auto dir = getWorkingTreeDir();
+	const auto baseCommit = QString::fromLatin1(
+	    hlp::runGitTool({"rev-parse", "--verify", baseRev + "^{commit}"}, dir).trimmed());
+
+	// Tree is built in a temporary index, so the index of the repository is not changed.
+	QTemporaryDir indexDir;
+	if (!indexDir.isValid()) {
+		raiseException(1, "creating temporary index");
+	}
+	const auto indexFile = indexDir.filePath("index");
+	hlp::runGitTool({"read-tree", baseCommit}, dir, {}, indexFile);
+
+	// Modes of existing files are kept.
+	const auto modes = getFileModes(hlp::runGitTool({"ls-files", "-s", "-z"}, dir, {}, indexFile),
+	                                blobs);
+	hlp::runGitTool({"update-index", "-z", "--index-info"}, dir, toIndexInfo(blobs, modes),
+	                indexFile);
+
+	const auto tree = QString::fromLatin1(
+	    hlp::runGitTool({"write-tree"}, dir, {}, indexFile).trimmed());
+	const auto commit = QString::fromLatin1(
+	    hlp::runGitTool({"commit-tree", tree, "-p", baseCommit, "-F", "-"}, dir, message.toUtf8())
+	        .trimmed());
+	hlp::runGitTool({"update-ref", "-m", message, ref, commit}, dir);
+	return commit;
+}
+
+void GitRepository::stageBlobs(const BlobIds &blobs) const
 {
-	return git_helpers::blameFile(getWorkingTreeDir(), filePath);
+	const auto dir = getWorkingTreeDir();
+	const auto modes = getFileModes(hlp::runGitTool({"ls-files", "-s", "-z"}, dir), blobs);
+	hlp::runGitTool({"update-index", "-z", "--index-info"}, dir, toIndexInfo(blobs, modes));
 }
 
 QString GitRepository::getWorkingTreeDir(const QString &filePath)
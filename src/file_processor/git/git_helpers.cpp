@@ -5,18 +5,45 @@
 #include <QDir>
 #include <QProcess>
 #include <QRegularExpression>
+#include <QThread>
+#include <QTimer>
 
 #include "src/logger/log.h"
+#include "src/profiler/profiler.h"
 
 namespace {
 
 using Msg = logger::MsgCode;
 
+const QLatin1String cGitProgram("git");
+
+void logProcessError(QProcess &p, const QString &program, const QStringList &arguments,
+                     bool isTimeout)
+{
+	QByteArray errorText = p.readAllStandardError().trimmed();
+	if (errorText.isEmpty()) {
+		errorText = p.readAllStandardOutput().trimmed();
+	}
+	CN_ERR(Msg::RunningExternalToolError,
+	       "Failed to run program [exitCode = " << p.exitCode() << ", isTimeout = " << isTimeout
+	                                            << "]: " << program << " " << arguments
+	                                            << ". Error: " << errorText.simplified());
+}
+
 QByteArray runProgram(const QString &program, const QStringList &arguments,
-                      const QString &workingDir = {})
+                      const QString &workingDir = {}, const QByteArray &input = {},
+                      const QString &indexFile = {},
+                      int timeoutMsecs = appconst::cProcessExecutionTimeout)
 {
+	const profiler::ScopedTimer timer(profiler::GitProcess);
+
 	QProcess p;
 	p.setWorkingDirectory(workingDir);
+	if (!indexFile.isEmpty()) {
+		auto environment = QProcessEnvironment::systemEnvironment();
+		environment.insert("GIT_INDEX_FILE", indexFile);
+		p.setProcessEnvironment(environment);
+	}
 	p.start(program, arguments);
 
 	if (!p.waitForStarted(appconst::cStartProcessTimeout)) {
@@ -25,23 +52,157 @@ QByteArray runProgram(const QString &program, const QStringList &arguments,
 		throw std::exception();
 	}
 
-	const bool isTimeout = !p.waitForFinished(appconst::cProcessExecutionTimeout);
+	if (!input.isEmpty()) {
+		p.write(input);
+	}
+	p.closeWriteChannel();
+
+	const bool isTimeout = !p.waitForFinished(timeoutMsecs);
 	if (isTimeout || p.exitCode() != EXIT_SUCCESS) {
-		QByteArray errorText = p.readAllStandardError().trimmed();
-		if (errorText.isEmpty()) {
-			errorText = p.readAllStandardOutput().trimmed();
-		}
-		CN_ERR(Msg::RunningExternalToolError,
-		       "Failed to run program [exitCode = " << p.exitCode() << ", isTimeout = " << isTimeout
-		                                            << "]: " << program << " " << arguments
-		                                            << ". Error: " << errorText.simplified());
+		logProcessError(p, program, arguments, isTimeout);
 		throw std::exception();
 	}
 
 	return p.readAllStandardOutput();
 }
 
-void parseBlameLine(const QByteArray &line, std::vector<GitBlameLine> &result)
+// QProcess needs an event loop, that pool threads do not have, so processes of runGitToolAsync()
+// are started and finished in this thread.
+struct ProcessThread
+{
+	ProcessThread()
+	{
+		thread.setObjectName("GitProcesses");
+		context.moveToThread(&thread);
+		thread.start();
+	}
+
+	~ProcessThread()
+	{
+		thread.quit();
+		thread.wait();
+	}
+
+	QThread thread;
+	QObject context;  // Lives in the thread, so queued calls are run there.
+};
+
+// Is called in the process thread.
+void startProcess(const QString &program, const QStringList &arguments,
+                  const QString &workingDir, const QByteArray &input,
+                  git_helpers::GitCallback onFinished)
+{
+	auto *process = new QProcess();
+	auto *timeoutTimer = new QTimer(process);
+	timeoutTimer->setSingleShot(true);
+	QObject::connect(timeoutTimer, &QTimer::timeout, process, &QProcess::kill);
+
+	// Either 'finished' or 'errorOccurred' with FailedToStart is emitted, not both.
+	const auto startNsecs = profiler::nowNsecs();
+	auto callback = std::make_shared<git_helpers::GitCallback>(std::move(onFinished));
+
+	const auto onProcessFinished = [=](int exitCode, QProcess::ExitStatus exitStatus) {
+		const auto endNsecs = profiler::nowNsecs();
+		profiler::record(profiler::GitProcess, endNsecs - startNsecs);
+		profiler::traceSpan(profiler::GitProcess, startNsecs, endNsecs);
+
+		const bool isTimeout = !timeoutTimer->isActive();
+		timeoutTimer->stop();
+
+		std::optional<QByteArray> output;
+		if (isTimeout || exitStatus != QProcess::NormalExit || exitCode != EXIT_SUCCESS) {
+			logProcessError(*process, program, arguments, isTimeout);
+		} else {
+			output = process->readAllStandardOutput();
+		}
+
+		process->deleteLater();
+		(*callback)(std::move(output));
+	};
+
+	const auto onProcessError = [=](QProcess::ProcessError error) {
+		if (error != QProcess::FailedToStart) {
+			return;
+		}
+
+		CN_ERR(Msg::RunningExternalToolError,
+		       "Failed to start program " << program << " " << arguments);
+		process->deleteLater();
+		(*callback)(std::nullopt);
+	};
+
+	QObject::connect(process, qOverload<int, QProcess::ExitStatus>(&QProcess::finished), process,
+	                 onProcessFinished);
+	QObject::connect(process, &QProcess::errorOccurred, process, onProcessError);
+	QObject::connect(process, &QProcess::started, process, [process, input] {
+		if (!input.isEmpty()) {
+			process->write(input);
+		}
+		process->closeWriteChannel();
+	});
+
+	process->setWorkingDirectory(workingDir);
+	process->start(program, arguments);
+	timeoutTimer->start(appconst::cProcessExecutionTimeout);
+}
+
+QStringList blameArguments(const QString &filePath, const QString &revision)
+{
+	return {"blame", revision, "-CC", "-w", "-l", "-f", "-t", "--date=iso", "--", filePath};
+}
+
+// Content is read from the standard input and blamed on top of HEAD.
+QStringList blameContentArguments(const QString &filePath)
+{
+	return {"blame", "--contents", "-", "-CC", "-w", "-l", "-f", "-t", "--date=iso", "--",
+	        filePath};
+}
+
+// Assigns dense ids to commits and authors while blame is parsed. Consecutive lines usually come
+// from the same commit, so the previous commit is checked before the hash lookup.
+struct BlameInterner
+{
+	explicit BlameInterner(GitBlame &blame)
+	    : m_blame(blame)
+	{}
+
+	void addLine(const QString &hash, const QString &author)
+	{
+		if (m_blame.lines.empty() || m_blame.commits[m_blame.lines.back()] != hash) {
+			m_lastCommitId = internCommit(hash, author);
+		}
+		m_blame.lines.emplace_back(m_lastCommitId);
+	}
+
+private:
+	GitBlame::Id internCommit(const QString &hash, const QString &author)
+	{
+		const auto [itr, isInserted] =
+		    m_commitIds.try_emplace(hash, static_cast<GitBlame::Id>(m_blame.commits.size()));
+		if (isInserted) {
+			m_blame.commits.emplace_back(hash);
+			m_blame.commitAuthors.emplace_back(internAuthor(author));
+		}
+		return itr->second;
+	}
+
+	GitBlame::Id internAuthor(const QString &author)
+	{
+		const auto [itr, isInserted] =
+		    m_authorIds.try_emplace(author, static_cast<GitBlame::Id>(m_blame.authors.size()));
+		if (isInserted) {
+			m_blame.authors.emplace_back(author);
+		}
+		return itr->second;
+	}
+
+	GitBlame &m_blame;
+	GitBlame::Id m_lastCommitId = 0;
+	std::unordered_map<QString, GitBlame::Id> m_commitIds;
+	std::unordered_map<QString, GitBlame::Id> m_authorIds;
+};
+
+void parseBlameLine(const QByteArray &line, BlameInterner &interner)
 {
 	// clang-format off
 	// https://regexr.com/6c4t7
@@ -62,12 +223,7 @@ void parseBlameLine(const QByteArray &line, std::vector<GitBlameLine> &result)
 		return;
 	}
 
-	// clang-format off
-	result.emplace_back(GitBlameLine{
-	    .hash = match.captured("hash"),
-	    .author = match.captured("author")
-	});
-	// clang-format on
+	interner.addLine(match.captured("hash"), match.captured("author"));
 }
 
 }  // namespace
@@ -76,25 +232,67 @@ namespace git_helpers {
 
 QByteArray runGitTool(const QStringList &arguments, const QString &workingDir)
 {
-	static const QLatin1String program("git");
-	CN_DEBUG("Running " << program << arguments);
-	return runProgram(program, arguments, workingDir);
+	CN_DEBUG("Running " << cGitProgram << arguments);
+	return runProgram(cGitProgram, arguments, workingDir);
 }
 
-std::vector<GitBlameLine> blameFile(const QString &repoRoot, const QString &filePath)
+QByteArray runGitTool(const QStringList &arguments, const QString &workingDir,
+                      const QByteArray &input, const QString &indexFile, int timeoutMsecs)
 {
-	const QStringList args = {"blame", "HEAD", "-CC",        "-w", "-l",
-	                          "-f",    "-t",   "--date=iso", "--", filePath};
-	const auto tokenizedBlame = runGitTool(args, repoRoot).split('\n');
+	CN_DEBUG("Running " << cGitProgram << arguments);
+	return runProgram(cGitProgram, arguments, workingDir, input, indexFile, timeoutMsecs);
+}
 
-	std::vector<GitBlameLine> result;
-	result.reserve(tokenizedBlame.size());
+void runGitToolAsync(const QStringList &arguments, const QString &workingDir,
+                     GitCallback onFinished)
+{
+	runGitToolAsync(arguments, workingDir, {}, std::move(onFinished));
+}
+
+void runGitToolAsync(const QStringList &arguments, const QString &workingDir,
+                     const QByteArray &input, GitCallback onFinished)
+{
+	static ProcessThread processThread;
+
+	CN_DEBUG("Running " << cGitProgram << arguments);
+	QMetaObject::invokeMethod(
+	    &processThread.context,
+	    [arguments, workingDir, input, onFinished = std::move(onFinished)]() mutable {
+		    startProcess(cGitProgram, arguments, workingDir, input, std::move(onFinished));
+	    },
+	    Qt::QueuedConnection);
+}
+
+GitBlame parseBlame(const QByteArray &blameOutput)
+{
+	const auto tokenizedBlame = blameOutput.split('\n');
+
+	GitBlame result;
+	result.lines.reserve(tokenizedBlame.size());
 
-	std::for_each(tokenizedBlame.cbegin(), tokenizedBlame.cend(), [&result](auto &&arg) {
-		parseBlameLine(std::forward<decltype(arg)>(arg), result);
+	BlameInterner interner(result);
+	std::for_each(tokenizedBlame.cbegin(), tokenizedBlame.cend(), [&interner](auto &&arg) {
+		parseBlameLine(std::forward<decltype(arg)>(arg), interner);
 	});
 
 	return result;
 }
 
+GitBlame blameFile(const QString &repoRoot, const QString &filePath, const QString &revision)
+{
+	return parseBlame(runGitTool(blameArguments(filePath, revision), repoRoot));
+}
+
+void blameFileAsync(const QString &repoRoot, const QString &filePath, const QString &revision,
+                    GitCallback onFinished)
+{
+	runGitToolAsync(blameArguments(filePath, revision), repoRoot, std::move(onFinished));
+}
+
+void blameContentAsync(const QString &repoRoot, const QString &filePath,
+                       const QByteArray &content, GitCallback onFinished)
+{
+	runGitToolAsync(blameContentArguments(filePath), repoRoot, content, std::move(onFinished));
+}
+
 }  // namespace git_helpers
\ No newline at end of file
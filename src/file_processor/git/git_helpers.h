@@ -1,13 +1,41 @@
 #pragma once
 
 #include <QString>
+#include <functional>
+#include <optional>
 #include <unordered_map>
 
-#include "GitBlameLine.h"
+#include "GitBlame.h"
+#include "src/constants.h"
 
 namespace git_helpers {
 
+// Gets output of the process or nothing, if it has failed (the error is already logged).
+using GitCallback = std::function<void(std::optional<QByteArray>)>;
+
 [[nodiscard]] QByteArray runGitTool(const QStringList &arguments, const QString &workingDir = {});
-[[nodiscard]] std::vector<GitBlameLine> blameFile(const QString &repoRoot, const QString &filePath);
+// Writes 'input' to the standard input of git. 'indexFile' replaces the index of the repository,
+// if it is set.
+[[nodiscard]] QByteArray runGitTool(const QStringList &arguments, const QString &workingDir,
+                                    const QByteArray &input, const QString &indexFile = {},
+                                    int timeoutMsecs = appconst::cProcessExecutionTimeout);
+// Starts git without blocking, 'onFinished' is called from another thread.
+void runGitToolAsync(const QStringList &arguments, const QString &workingDir,
+                     GitCallback onFinished);
+// Writes 'input' to the standard input of git, once it is started.
+void runGitToolAsync(const QStringList &arguments, const QString &workingDir,
+                     const QByteArray &input, GitCallback onFinished);
+// Parses output of 'git blame -l -f'.
+[[nodiscard]] GitBlame parseBlame(const QByteArray &blameOutput);
+// Blames the file as of 'revision'. Relative 'filePath' is relative to 'repoRoot'.
+[[nodiscard]] GitBlame blameFile(const QString &repoRoot, const QString &filePath,
+                                 const QString &revision);
+// Output is passed to parseBlame() by the caller, so it is parsed on the caller's thread.
+void blameFileAsync(const QString &repoRoot, const QString &filePath, const QString &revision,
+                    GitCallback onFinished);
+// Blames 'content' as a new version of the file on top of HEAD, e.g. its staged blob. Lines, that
+// are not committed yet, belong to GitBlame::cUncommittedHash.
+void blameContentAsync(const QString &repoRoot, const QString &filePath,
+                       const QByteArray &content, GitCallback onFinished);
 
 }  // namespace git_helpers
\ No newline at end of file
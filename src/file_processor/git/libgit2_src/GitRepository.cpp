@@ -1,6 +1,7 @@
 #include "GitRepository.h"
 
 #include <QRegularExpression>
+#include <memory>
 
 #include <git2.h>
 
@@ -36,6 +37,104 @@ QString getHash(const git_commit &commit)
 	return QString::fromStdString(buf.data());
 }
 
+template<typename T, void (*free)(T *)>
+struct Deleter
+{
+	void operator()(T *object) const { free(object); }
+};
+using CommitPtr = std::unique_ptr<git_commit, Deleter<git_commit, git_commit_free>>;
+using BlobPtr = std::unique_ptr<git_blob, Deleter<git_blob, git_blob_free>>;
+using IndexPtr = std::unique_ptr<git_index, Deleter<git_index, git_index_free>>;
+using DiffPtr = std::unique_ptr<git_diff, Deleter<git_diff, git_diff_free>>;
+using TreePtr = std::unique_ptr<git_tree, Deleter<git_tree, git_tree_free>>;
+using TreeBuilderPtr =
+    std::unique_ptr<git_treebuilder, Deleter<git_treebuilder, git_treebuilder_free>>;
+using SignaturePtr = std::unique_ptr<git_signature, Deleter<git_signature, git_signature_free>>;
+using ReferencePtr = std::unique_ptr<git_reference, Deleter<git_reference, git_reference_free>>;
+
+// Files, which paths are relative to the tree, that is being built.
+using TreeFiles = std::vector<std::pair<std::string, git_oid>>;
+
+// Builds the tree from 'baseTree' (null for a new one) with replaced 'files'. Only trees on the
+// paths of the files are written, other entries keep their ids.
+git_oid writeTree(git_repository *repo, const git_tree *baseTree, const TreeFiles &files)
+{
+	git_treebuilder *builderPtr = nullptr;
+	checkError(git_treebuilder_new(&builderPtr, repo, baseTree), "creating tree builder");
+	const TreeBuilderPtr builder(builderPtr);
+
+	std::map<std::string, TreeFiles> subdirFiles;
+	for (const auto &[path, id] : files) {
+		const auto slash = path.find('/');
+		if (slash != std::string::npos) {
+			subdirFiles[path.substr(0, slash)].emplace_back(path.substr(slash + 1), id);
+			continue;
+		}
+
+		// Modes of existing files are kept, new files are added as regular ones.
+		const auto *entry = git_treebuilder_get(builder.get(), path.c_str());
+		const auto mode = entry ? git_tree_entry_filemode(entry) : GIT_FILEMODE_BLOB;
+		checkError(git_treebuilder_insert(nullptr, builder.get(), path.c_str(), &id, mode),
+		           "inserting blob");
+	}
+
+	for (const auto &[dir, dirFiles] : subdirFiles) {
+		git_tree *subtreePtr = nullptr;
+		const auto *entry = git_treebuilder_get(builder.get(), dir.c_str());
+		if (entry && git_tree_entry_type(entry) == GIT_OBJECT_TREE) {
+			checkError(git_tree_lookup(&subtreePtr, repo, git_tree_entry_id(entry)),
+			           "looking up tree");
+		}
+		const TreePtr subtree(subtreePtr);
+
+		const auto subtreeId = writeTree(repo, subtree.get(), dirFiles);
+		checkError(git_treebuilder_insert(nullptr, builder.get(), dir.c_str(), &subtreeId,
+		                                  GIT_FILEMODE_TREE),
+		           "inserting tree");
+	}
+
+	git_oid id;
+	checkError(git_treebuilder_write(&id, builder.get()), "writing tree");
+	return id;
+}
+
+git_oid toOid(const QString &hash)
+{
+	git_oid id;
+	checkError(git_oid_fromstr(&id, hash.toLatin1().constData()), "parsing object id");
+	return id;
+}
+
+QString toHash(const git_oid &id)
+{
+	std::array<char, GIT_OID_HEXSZ + 1> buf{};
+	git_oid_tostr(buf.data(), buf.size(), &id);
+	return QString::fromLatin1(buf.data());
+}
+
+CommitPtr lookupCommit(git_repository *repo, const QString &revision)
+{
+	git_object *object = nullptr;
+	checkError(git_revparse_single(&object, repo, revision.toUtf8().constData()),
+	           "resolving revision");
+	git_object *commitObject = nullptr;
+	const auto ec = git_object_peel(&commitObject, object, GIT_OBJECT_COMMIT);
+	git_object_free(object);
+	checkError(ec, "resolving commit");
+	return CommitPtr(reinterpret_cast<git_commit *>(commitObject));
+}
+
+int addTreeFile(const char *root, const git_tree_entry *entry, void *payload)
+{
+	const auto mode = git_tree_entry_filemode(entry);
+	if (mode == GIT_FILEMODE_BLOB || mode == GIT_FILEMODE_BLOB_EXECUTABLE) {
+		auto &files = *static_cast<std::vector<GitRepository::TreeFile> *>(payload);
+		files.push_back({QString::fromUtf8(root) + QString::fromUtf8(git_tree_entry_name(entry)),
+		                 toHash(*git_tree_entry_id(entry))});
+	}
+	return 0;
+}
+
 }  // namespace
 
 GitRepository::GitRepository(QString repoPath) noexcept
@@ -70,14 +169,22 @@ void GitRepository::open()
 
 QString GitRepository::getWorkingTreeDir() const
 {
-	return QString::fromUtf8(git_repository_path(m_repo))
-	    .section('/', 0, -2, QString::SectionSkipEmpty);
+	// Git directory of a submodule is inside of the superproject's one, so working tree is taken
+	// directly. Bare repositories have no working tree, their git directory is used instead.
+	const char *workdir = git_repository_workdir(m_repo);
+	auto workingTreeDir = QString::fromUtf8(workdir ? workdir : git_repository_path(m_repo));
+	if (workingTreeDir.size() > 1 && workingTreeDir.endsWith('/')) {
+		workingTreeDir.chop(1);
+	}
+	return workingTreeDir;
 }
 
-std::vector<QString> GitRepository::getBrokenCommits() const
+std::vector<QString> GitRepository::getBrokenCommits(const QString &revision) const
 {
 	constexpr int maxParentsCommitsLimit = 2;
 
+	const auto tip = lookupCommit(m_repo, revision);
+
 	std::vector<QString> result;
 	git_revwalk *walker = nullptr;
 	git_oid oid;
@@ -85,8 +192,8 @@ std::vector<QString> GitRepository::getBrokenCommits() const
 	auto ec = git_revwalk_new(&walker, m_repo);
 	checkError(ec, "could not create revision walker");
 
-	ec = git_revwalk_push_head(walker);
-	checkError(ec, "could not find repository HEAD");
+	ec = git_revwalk_push(walker, git_commit_id(tip.get()));
+	checkError(ec, "could not push revision");
 
 	result.reserve(appconst::cPossibleBrokenCommitsNumber);
 	for (git_commit *commit{}; !git_revwalk_next(&oid, walker); git_commit_free(commit)) {
@@ -110,9 +217,144 @@ std::vector<QString> GitRepository::getBrokenCommits() const
 	return result;
 }
 
-std::vector<GitBlameLine> GitRepository::blameFile(const QString &filePath) const
+GitBlame GitRepository::blameFile(const QString &filePath, const QString &revision) const
 {
-	return git_helpers::blameFile(getWorkingTreeDir(), filePath);
+	return git_helpers::blameFile(getWorkingTreeDir(), filePath, revision);
+}
+
+std::vector<GitRepository::TreeFile> GitRepository::listFiles(const QString &revision) const
+{
+	const auto commit = lookupCommit(m_repo, revision);
+	git_tree *treePtr = nullptr;
+	checkError(git_commit_tree(&treePtr, commit.get()), "looking up tree");
+	const TreePtr tree(treePtr);
+
+	std::vector<TreeFile> files;
+	checkError(git_tree_walk(tree.get(), GIT_TREEWALK_PRE, addTreeFile, &files), "walking tree");
+	return files;
+}
+
+std::vector<GitRepository::TreeFile> GitRepository::listStagedFiles() const
+{
+	// Everything in the index is staged, if there is no HEAD yet.
+	TreePtr headTree;
+	if (git_repository_head_unborn(m_repo) != 1) {
+		const auto head = lookupCommit(m_repo, appconst::cHeadRevision);
+		git_tree *treePtr = nullptr;
+		checkError(git_commit_tree(&treePtr, head.get()), "looking up HEAD tree");
+		headTree.reset(treePtr);
+	}
+
+	git_index *indexPtr = nullptr;
+	checkError(git_repository_index(&indexPtr, m_repo), "reading index");
+	const IndexPtr index(indexPtr);
+
+	git_diff *diffPtr = nullptr;
+	checkError(git_diff_tree_to_index(&diffPtr, m_repo, headTree.get(), index.get(), nullptr),
+	           "comparing index with HEAD");
+	const DiffPtr diff(diffPtr);
+
+	std::vector<TreeFile> files;
+	for (std::size_t i = 0, count = git_diff_num_deltas(diff.get()); i < count; i++) {
+		const auto *delta = git_diff_get_delta(diff.get(), i);
+		const auto mode = delta->new_file.mode;
+		const bool isStaged =
+		    delta->status == GIT_DELTA_ADDED || delta->status == GIT_DELTA_MODIFIED;
+		if (isStaged && (mode == GIT_FILEMODE_BLOB || mode == GIT_FILEMODE_BLOB_EXECUTABLE)) {
+			files.push_back({QString::fromUtf8(delta->new_file.path), toHash(delta->new_file.id)});
+		}
+	}
+	return files;
+}
+
+std::vector<QByteArray> GitRepository::readBlobs(const std::vector<QString> &blobIds) const
+{
+	std::vector<QByteArray> blobs;
+	blobs.reserve(blobIds.size());
+	for (const auto &id : blobIds) {
+		const auto oid = toOid(id);
+		git_blob *blobPtr = nullptr;
+		checkError(git_blob_lookup(&blobPtr, m_repo, &oid), "reading blob");
+		const BlobPtr blob(blobPtr);
+
+		blobs.emplace_back(static_cast<const char *>(git_blob_rawcontent(blob.get())),
+		                   static_cast<int>(git_blob_rawsize(blob.get())));
+	}
+	return blobs;
+}
+
+QString GitRepository::writeBlob(const QByteArray &content) const
+{
+	git_oid id;
+	checkError(git_blob_create_from_buffer(&id, m_repo, content.constData(),
+	                                       static_cast<std::size_t>(content.size())),
+	           "writing blob");
+	return toHash(id);
+}
+
+QString GitRepository::commitBlobs(const QString &baseRev, const BlobIds &blobs,
+                                   const QString &ref, const QString &message) const
+{
+	const auto baseCommit = lookupCommit(m_repo, baseRev);
+
+	git_tree *baseTreePtr = nullptr;
+	checkError(git_commit_tree(&baseTreePtr, baseCommit.get()), "looking up base tree");
+	const TreePtr baseTree(baseTreePtr);
+
+	TreeFiles files;
+	files.reserve(blobs.size());
+	for (const auto &[path, blobId] : blobs) {
+		files.emplace_back(path.toStdString(), toOid(blobId));
+	}
+	const auto treeId = writeTree(m_repo, baseTree.get(), files);
+
+	git_tree *treePtr = nullptr;
+	checkError(git_tree_lookup(&treePtr, m_repo, &treeId), "looking up new tree");
+	const TreePtr tree(treePtr);
+
+	// User is taken from git configuration, like with 'git commit'.
+	git_signature *signaturePtr = nullptr;
+	checkError(git_signature_default(&signaturePtr, m_repo), "creating signature");
+	const SignaturePtr signature(signaturePtr);
+
+	git_oid commitId;
+	const git_commit *parents[] = {baseCommit.get()};
+	const auto messageData = message.toUtf8();
+	checkError(git_commit_create(&commitId, m_repo, nullptr, signature.get(), signature.get(),
+	                             nullptr, messageData.constData(), tree.get(), 1, parents),
+	           "creating commit");
+
+	// Ref is moved even if it points elsewhere, like 'git branch -f'.
+	git_reference *refPtr = nullptr;
+	checkError(git_reference_create(&refPtr, m_repo, ref.toUtf8().constData(), &commitId, 1,
+	                                messageData.constData()),
+	           "updating reference");
+	const ReferencePtr reference(refPtr);
+
+	return toHash(commitId);
+}
+
+void GitRepository::stageBlobs(const BlobIds &blobs) const
+{
+	git_index *indexPtr = nullptr;
+	checkError(git_repository_index(&indexPtr, m_repo), "reading index");
+	const IndexPtr index(indexPtr);
+
+	for (const auto &[path, blobId] : blobs) {
+		const auto pathData = path.toUtf8();
+		const auto *staged = git_index_get_bypath(index.get(), pathData.constData(), 0);
+		if (!staged) {
+			checkError(GIT_ENOTFOUND, "finding staged file");
+		}
+
+		// Stat data belongs to the old content, so it is not copied, and git checks the file again.
+		git_index_entry entry{};
+		entry.mode = staged->mode;
+		entry.id = toOid(blobId);
+		entry.path = pathData.constData();
+		checkError(git_index_add(index.get(), &entry), "staging blob");
+	}
+	checkError(git_index_write(index.get()), "writing index");
 }
 
 QString GitRepository::getWorkingTreeDir(const QString &filePath)
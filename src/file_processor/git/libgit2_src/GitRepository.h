@@ -1,6 +1,7 @@
 #pragma once
 
 #include <QString>
+#include <map>
 #include <vector>
 
 struct GitRepository
@@ -12,8 +13,33 @@ struct GitRepository
 
 	void open();
 	[[nodiscard]] QString getWorkingTreeDir() const;
-	[[nodiscard]] std::vector<QString> getBrokenCommits() const;
-	[[nodiscard]] std::vector<struct GitBlameLine> blameFile(const QString &filePath) const;
+	[[nodiscard]] std::vector<QString> getBrokenCommits(const QString &revision) const;
+	[[nodiscard]] struct GitBlame blameFile(const QString &filePath, const QString &revision) const;
+
+	struct TreeFile
+	{
+		QString path;  // Relative to the root of the tree.
+		QString blobId;
+	};
+	// Regular files of the tree of 'revision', including ones in subdirectories. Symbolic links
+	// and submodules are skipped.
+	[[nodiscard]] std::vector<TreeFile> listFiles(const QString &revision) const;
+	// Files, that are added or modified in the index since HEAD, with ids of their staged blobs.
+	// Symbolic links, submodules and unmerged files are skipped.
+	[[nodiscard]] std::vector<TreeFile> listStagedFiles() const;
+	// Reads contents of the blobs at once.
+	[[nodiscard]] std::vector<QByteArray> readBlobs(const std::vector<QString> &blobIds) const;
+
+	// Relative paths of files in the repository and ids of their new blobs.
+	using BlobIds = std::map<QString, QString>;
+	// Writes 'content' to the object database and returns id of the blob.
+	[[nodiscard]] QString writeBlob(const QByteArray &content) const;
+	// Creates commit, which tree is the tree of 'baseRev' with 'blobs' replaced, moves 'ref' to it
+	// and returns its id. Neither the working tree nor the index are changed.
+	QString commitBlobs(const QString &baseRev, const BlobIds &blobs, const QString &ref,
+	                    const QString &message) const;
+	// Replaces blobs of staged files in the index. Modes of the files are kept.
+	void stageBlobs(const BlobIds &blobs) const;
 
 	[[nodiscard]] static QString getWorkingTreeDir(const QString &filePath);
 
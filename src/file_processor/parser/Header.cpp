@@ -4,13 +4,13 @@
 
 #include "src/configuration/StaticConfig.h"
 #include "src/logger/log.h"
+#include "src/profiler/profiler.h"
 
 #include "header_utils.h"
 
 namespace {
 
 using Msg = logger::MsgCode;
-using HeaderFieldsVec = std::vector<std::pair<Header::HeaderFieldType, std::any>>;
 
 void printPossibleAuthors(const auto &ctx, const auto &authors)
 {
@@ -26,12 +26,63 @@ void printPossibleAuthors(const auto &ctx, const auto &authors)
 	           << authorsStr);
 }
 
-int maxAlignedFieldNameLength(const HeaderFieldsVec &fields)
+Header::FieldValue toFieldValue(Header::RawFieldValue rawValue)
+{
+	return QString::fromUtf8(rawValue.data(), static_cast<int>(rawValue.size()));
+}
+
+constexpr bool isFieldSet(const Header::Field &field)
+{
+	return !std::holds_alternative<std::monostate>(field);
+}
+
+// Calls 'fn' for every value of the field, not decoded values are passed as is.
+void forEachValue(const Header::Field &field, const auto &fn)
+{
+	if (const auto *value = std::get_if<Header::FieldValue>(&field)) {
+		fn(*value);
+	} else if (const auto *list = std::get_if<Header::FieldList>(&field)) {
+		std::for_each(list->cbegin(), list->cend(), fn);
+	} else if (const auto *rawValue = std::get_if<Header::RawFieldValue>(&field)) {
+		fn(*rawValue);
+	} else if (const auto *rawList = std::get_if<Header::RawFieldList>(&field)) {
+		std::for_each(rawList->cbegin(), rawList->cend(), fn);
+	}
+}
+
+std::size_t serializedValueSize(const Header::FieldValue &value)
+{
+	return header_helpers::utf8Size(value);
+}
+
+std::size_t serializedValueSize(Header::RawFieldValue value)
+{
+	return value.size();
+}
+
+char *writeBytes(std::string_view bytes, char *out)
+{
+	return std::copy(bytes.cbegin(), bytes.cend(), out);
+}
+
+char *writeValue(const Header::FieldValue &value, char *out)
+{
+	return header_helpers::writeUtf8(value, out);
+}
+
+char *writeValue(Header::RawFieldValue value, char *out)
+{
+	return writeBytes(value, out);
+}
+
+int maxAlignedFieldNameLength(const auto &fields)
 {
 	int max = 0;
-	for (const auto &[type, _] : fields) {
-		if (type != Header::HeaderFieldType::Component) {
-			max = std::max(max, header_fields::toFieldName(type).size());
+	for (int type = 0; type < header_fields::FieldTypeCount; type++) {
+		if (type != Header::HeaderFieldType::Component && isFieldSet(fields[type])) {
+			const auto fieldType = static_cast<Header::HeaderFieldType>(type);
+			const auto nameLength = header_fields::toRawFieldName(fieldType).size();
+			max = std::max(max, static_cast<int>(nameLength));
 		}
 	}
 	return max;
@@ -55,15 +106,19 @@ Header::Header(const Context &ctx, const QByteArray &content, GitRepository repo
 
 void Header::load()
 {
-	initRegex();
+	initMarkers();
 
-	m_headerRangeOpt = header_helpers::headerRange(m_content.data(), m_prefix, m_suffix);
+	const auto maxHeaderOffset = static_cast<std::size_t>(m_ctx.config.maxHeaderOffset());
+	m_headerRangeOpt =
+	    header_helpers::headerRange(contentView(), m_prefix, m_suffix, maxHeaderOffset);
 	if (!m_headerRangeOpt.has_value()) {
+		m_isUnterminated = header_helpers::findHeaderStart(contentView(), m_prefix, maxHeaderOffset)
+		    != std::string_view::npos;
 		return;
 	}
 
 	const auto headerRange = m_headerRangeOpt.value();
-	m_rawHeader = header_helpers::getHeader(m_content.data(), headerRange);
+	m_rawHeader = header_helpers::getHeader(contentView(), headerRange);
 }
 
 void Header::parse()
@@ -86,42 +141,74 @@ void Header::parse()
 
 bool Header::fix()
 {
-	bool hasChanges = false;
+	fixFields();
+	return fixAuthors();
+}
+
+bool Header::fixFields()
+{
+	// In check mode we only need to know whether anything differs, so cheap fields are compared
+	// first and blaming is skipped as soon as any of them is outdated.
+	const bool stopAtFirstChange = m_ctx.config.options() & RunOption::CheckMode;
 
 	if (m_ctx.config.options() & RunOption::UpdateFileName) {
 		auto fileName = m_ctx.targetPath.mid(m_ctx.targetPath.lastIndexOf("/") + 1);
-		hasChanges |= fixField(HeaderFieldType::File, std::move(fileName));
+		m_hasChanges |= fixField(HeaderFieldType::File, std::move(fileName));
+	}
+
+	if (m_hasChanges && stopAtFirstChange) {
+		return true;
 	}
 
 	if (m_ctx.config.options() & RunOption::UpdateCopyright) {
 		const auto &copyrightTemplate = getStaticConfig(m_ctx).copyrightFieldTemplate();
 		static const auto copyrightValue = header_fields::makeCopyrightValue(copyrightTemplate);
-		hasChanges |= fixField(HeaderFieldType::Copyright, copyrightValue);
+		m_hasChanges |= fixField(HeaderFieldType::Copyright, copyrightValue);
+	}
+
+	if (m_hasChanges && stopAtFirstChange) {
+		return true;
 	}
 
 	if (m_ctx.config.options() & RunOption::UpdateComponent) {
 		const auto &componentName = m_ctx.config.componentName();
 		if (componentName.isEmpty()) {
-			m_fields.erase(HeaderFieldType::Component);
-			hasChanges = true;
+			m_fields[HeaderFieldType::Component] = std::monostate();
+			m_stats.changedFields.emplace_back(HeaderFieldType::Component);
+			m_hasChanges = true;
 		} else {
-			hasChanges |= fixField(HeaderFieldType::Component, componentName);
+			m_hasChanges |= fixField(HeaderFieldType::Component, componentName);
 		}
 	}
 
-	bool authorsUpdated = false;
-	if (m_ctx.config.options() & RunOption::UpdateAuthors) {
-		std::vector<QString> authors;
+	return m_hasChanges;
+}
 
-		if (mayUpdateAuthors()) {
-			authors = getAuthors();
+bool Header::needsBlame() const
+{
+	const bool stopAtFirstChange = m_ctx.config.options() & RunOption::CheckMode;
+	return !(m_hasChanges && stopAtFirstChange)
+	    && m_ctx.config.options().testFlag(RunOption::UpdateAuthors) && mayUpdateAuthors();
+}
 
-			if (authors.size() <= m_ctx.config.maxBlameAuthors()) {
-				hasChanges |= fixField(HeaderFieldType::Author, std::move(authors));
-				authorsUpdated = hasChanges;
-			} else {
-				printPossibleAuthors(m_ctx, authors);
-			}
+void Header::setBlame(GitBlame blame, qint64 blameNsecs)
+{
+	m_stats.blameNsecs = blameNsecs;
+	m_stats.blameLineCount = blame.lines.size();
+	m_blame = std::move(blame);
+}
+
+bool Header::fixAuthors()
+{
+	bool authorsUpdated = false;
+	if (needsBlame()) {
+		auto authors = getAuthors();
+
+		if (authors.size() <= m_ctx.config.maxBlameAuthors()) {
+			m_hasChanges |= fixField(HeaderFieldType::Author, std::move(authors));
+			authorsUpdated = m_hasChanges;
+		} else {
+			printPossibleAuthors(m_ctx, authors);
 		}
 	}
 
@@ -129,82 +216,118 @@ bool Header::fix()
 		CN_DEBUG("Skip author field updates.");
 	}
 
-	return hasChanges;
+	return m_hasChanges;
 }
 
-QByteArray Header::serialize() const
+std::size_t Header::serializedSize() const
 {
 	namespace flds = header_fields;
 
-	auto fields = HeaderFieldsVec(m_fields.begin(), m_fields.end());
-	std::sort(fields.begin(), fields.end(),
-	          [](const auto &l, const auto &r) { return l.first < r.first; });
+	const auto maxFieldNameLength = static_cast<std::size_t>(maxAlignedFieldNameLength(m_fields));
 
-	const int maxFieldNameLength = maxAlignedFieldNameLength(fields);
+	std::size_t size = m_prefix.size();
+	for (int type = 0; type < flds::FieldTypeCount; type++) {
+		const auto fieldType = static_cast<HeaderFieldType>(type);
+		const auto fieldName = flds::toRawFieldName(fieldType);
 
-	QByteArray result;
-	QTextStream stream(&result);
-	const auto serializeLine = [&](HeaderFieldType type, const QString &value) {
-		if (type == HeaderFieldType::Component) {
-			stream << m_start.data() << '\n';
+		// "<start> <padded field name> <value>[.]\n", component is separated by "<start>\n".
+		std::size_t lineSize = m_start.size() + 1 + std::max(fieldName.size(), maxFieldNameLength)
+		    + 1 + (flds::requiresFullstop(fieldType) ? 1 : 0) + 1;
+		if (fieldType == HeaderFieldType::Component) {
+			lineSize += m_start.size() + 1;
 		}
 
-		stream << m_start.data() << ' ' << qSetFieldWidth(maxFieldNameLength) << Qt::left
-		       << flds::toFieldName(type).toLatin1() << qSetFieldWidth(0) << ' ' << value;
+		forEachValue(m_fields[type], [lineSize, &size](const auto &value) {
+			size += lineSize + serializedValueSize(value);
+		});
+	}
+
+	// The same last byte, that serialize() writes before the suffix.
+	const bool hasFields = size > m_prefix.size();
+	const bool overlapsSuffix = !m_suffix.empty()
+	    && (hasFields ? m_suffix.front() == '\n'
+	                  : !m_prefix.empty() && m_prefix.back() == m_suffix.front());
+	return size + m_suffix.size() - (overlapsSuffix ? 1 : 0);
+}
 
-		if (flds::requiresFullstop(type)) {
-			stream << '.';
-		}
+char *Header::serialize(char *out) const
+{
+	namespace flds = header_fields;
 
-		stream << '\n';
-	};
-
-	stream << m_prefix.data();
-	for (const auto &[type, valueAny] : fields) {
-		if (valueAny.type() == typeid(FieldList)) {
-			const auto &value = any_cast<const FieldList &>(valueAny);
-			std::for_each(value.cbegin(), value.cend(), [type, &serializeLine](const auto &value) {
-				serializeLine(type, value);
-			});
-			continue;
-		}
+	const auto maxFieldNameLength = static_cast<std::size_t>(maxAlignedFieldNameLength(m_fields));
+
+	const char *begin = out;
+	out = writeBytes(m_prefix, out);
+	for (int type = 0; type < flds::FieldTypeCount; type++) {
+		const auto fieldType = static_cast<HeaderFieldType>(type);
+		const auto fieldName = flds::toRawFieldName(fieldType);
+		const auto padding = maxFieldNameLength - std::min(fieldName.size(), maxFieldNameLength);
+
+		forEachValue(m_fields[type], [&](const auto &value) {
+			if (fieldType == HeaderFieldType::Component) {
+				out = writeBytes(m_start, out);
+				*out++ = '\n';
+			}
+
+			out = writeBytes(m_start, out);
+			*out++ = ' ';
+			out = writeBytes(fieldName, out);
+			out = std::fill_n(out, padding, ' ');
+			*out++ = ' ';
+			out = writeValue(value, out);
+
+			if (flds::requiresFullstop(fieldType)) {
+				*out++ = '.';
+			}
 
-		const auto &value = any_cast<const FieldValue &>(valueAny);
-		serializeLine(type, value);
+			*out++ = '\n';
+		});
 	}
-	stream << Qt::flush;
 
-	// Replace last '\n' character to the suffix (result will automatically resize to proper size).
-	result.replace(result.size() - 1, static_cast<int>(m_suffix.size()), m_suffix.data());
+	// The last line break (or the last prefix byte, if there are no fields) is shared with the
+	// suffix, like header_helpers::headerRange expects it.
+	const bool overlapsSuffix = out != begin && !m_suffix.empty() && out[-1] == m_suffix.front();
+	return writeBytes(m_suffix, overlapsSuffix ? out - 1 : out);
+}
+
+QByteArray Header::serialize() const
+{
+	QByteArray result(static_cast<int>(serializedSize()), Qt::Uninitialized);
+	serialize(result.data());
 	return result;
 }
 
+std::size_t Header::headerEndOffset() const
+{
+	if (!m_headerRangeOpt.has_value()) {
+		return 0;
+	}
+
+	const auto headerRange = m_headerRangeOpt.value();
+	return static_cast<std::size_t>(std::distance(contentView().begin(), headerRange.second));
+}
+
 QByteArray Header::contentWithoutHeader() const
 {
 	if (!m_headerRangeOpt.has_value()) {
 		return m_content;
 	}
 
-	const auto contentView = std::string_view(m_content.data());
-	const auto headerRange = m_headerRangeOpt.value();
-	const auto headerEndDistance = std::distance(contentView.begin(), headerRange.second);
-	return m_content.mid(static_cast<int>(headerEndDistance));
+	const auto headerEndDistance = static_cast<int>(headerEndOffset());
+	const auto restSize = m_content.size() - headerEndDistance;
+	return QByteArray::fromRawData(m_content.constData() + headerEndDistance, restSize);
+}
+
+std::string_view Header::contentView() const
+{
+	return {m_content.constData(), static_cast<std::size_t>(m_content.size())};
 }
 
-void Header::initRegex()
+void Header::initMarkers()
 {
 	m_prefix = header_utils::prefixMap[m_ext];
 	m_start = header_utils::startMap[m_ext];
 	m_suffix = header_utils::suffixMap[m_ext];
-
-	// clang-format off
-    static const QLatin1String pattern("^" "%1" "(?P<fieldData> (?P<fieldName>" "%2" ") +(?P<fieldValue>.*))?$");
-	// clang-format on
-
-	const auto start = QString::fromLatin1(m_start.data());
-	m_regex.setPattern(
-	    pattern.arg(QRegularExpression::escape(start), header_fields::allWithSeparator));
-	assert(m_regex.isValid());
 }
 
 void Header::parseField(std::string_view rawField)
@@ -213,85 +336,73 @@ void Header::parseField(std::string_view rawField)
 		return;
 	}
 
-	const auto qRawField = QString::fromUtf8(rawField.data(), static_cast<int>(rawField.size()));
-	const auto match = m_regex.match(qRawField);
+	const auto token = header_helpers::tokenizeField(rawField, m_start);
 
-	if (!match.hasMatch()) {
+	if (!token.has_value()) {
 		CN_ERR(Msg::BadHeaderFormat, "Error matching header for " << m_ctx.targetPath << '.');
 		throw std::exception();
 	}
 
-	if (match.captured("fieldData").isEmpty()) {
+	if (token->type == HeaderFieldType::Default) {
 		return;
 	}
 
-	const auto fieldName = match.captured("fieldName");
-	const auto fieldType = header_fields::toFieldType(fieldName);
-	auto fieldValue = match.captured("fieldValue");
+	const auto fieldType = token->type;
+	auto fieldValue = token->value;
 
-	if (header_fields::requiresFullstop(fieldType) && fieldValue.endsWith('.')) {
-		fieldValue.chop(1);
+	if (header_fields::requiresFullstop(fieldType) && fieldValue.ends_with('.')) {
+		fieldValue.remove_suffix(1);
 	}
 
-	const bool isFieldExist = m_fields.contains(fieldType);
+	auto &field = m_fields[fieldType];
 	if (header_fields::isListField(fieldType)) {
-		if (!isFieldExist) {
-			m_fields[fieldType] = FieldList{fieldValue};
+		if (auto *list = std::get_if<RawFieldList>(&field)) {
+			list->emplace_back(fieldValue);
 		} else {
-			any_cast<FieldList &>(m_fields[fieldType]).emplace_back(std::move(fieldValue));
+			field = RawFieldList{fieldValue};
 		}
 	} else {
-		if (isFieldExist) {
+		if (isFieldSet(field)) {
 			CN_DEBUG(header_fields::toFieldName(fieldType)
 			         << "field was met again in the same header in" << m_ctx.targetPath);
 		}
-		m_fields[fieldType] = std::move(fieldValue);
+		field = fieldValue;
 	}
 }
 
-bool Header::fixField(HeaderFieldType name, std::any valueAny)
+void Header::decodeField(HeaderFieldType type)
 {
-	const bool shouldFix = valueAny.type() == typeid(FieldList)
-	    ? shouldFixListField(name, any_cast<const FieldList &>(valueAny))
-	    : shouldFixValueField(name, any_cast<const FieldValue &>(valueAny));
-
-	if (!shouldFix) {
-		return false;
+	auto &field = m_fields[type];
+	if (const auto *rawList = std::get_if<RawFieldList>(&field)) {
+		FieldList list;
+		list.reserve(rawList->size());
+		std::transform(rawList->cbegin(), rawList->cend(), std::back_inserter(list), toFieldValue);
+		field = std::move(list);
+	} else if (const auto *rawValue = std::get_if<RawFieldValue>(&field)) {
+		field = toFieldValue(*rawValue);
 	}
-
-	m_fields[name] = std::move(valueAny);
-	return true;
 }
 
-bool Header::shouldFixListField(HeaderFieldType type, const Header::FieldList &value) const
+bool Header::fixField(HeaderFieldType type, Field value)
 {
-	if (m_fields.contains(type)) {
-		const auto &fieldList = any_cast<const FieldList &>(m_fields.at(type));
-		if (std::equal(value.begin(), value.end(), fieldList.begin(), fieldList.end())) {
-			return false;
-		}
-	}
-	return true;
-}
+	decodeField(type);
 
-bool Header::shouldFixValueField(HeaderFieldType type, const Header::FieldValue &value) const
-{
-	if (m_fields.contains(type)) {
-		const auto &fieldValue = any_cast<const FieldValue &>(m_fields.at(type));
-		if (value == fieldValue) {
-			return false;
-		}
+	// Not set field differs from any value, even from an empty list.
+	if (m_fields[type] == value) {
+		return false;
 	}
+
+	m_fields[type] = std::move(value);
+	m_stats.changedFields.emplace_back(type);
 	return true;
 }
 
 bool Header::mayUpdateAuthors() const
 {
-	bool isAuthorFieldExist = false;
-	if (m_fields.contains(HeaderFieldType::Author)) {
-		const auto &authors = any_cast<const FieldList &>(m_fields.at(HeaderFieldType::Author));
-		isAuthorFieldExist = !authors.empty();
-	}
+	const auto &authors = m_fields[HeaderFieldType::Author];
+	const auto *rawList = std::get_if<RawFieldList>(&authors);
+	const auto *list = std::get_if<FieldList>(&authors);
+	const bool isAuthorFieldExist = (rawList && !rawList->empty()) || (list && !list->empty());
 	const bool mustUpdateOnlyIfEmpty =
 	    m_ctx.config.options().testFlag(RunOption::UpdateAuthorsOnlyIfEmpty);
 	return !(mustUpdateOnlyIfEmpty && isAuthorFieldExist);
@@ -306,14 +417,30 @@ std::vector<QString> Header::getAuthors()
 	const bool skipBrokenCommit = !m_ctx.config.options().testFlag(RunOption::DontSkipBrokenMerges);
 
 	const auto &authorAliases = getStaticConfig(m_ctx).authorAliases();
+	const auto &revision = m_ctx.config.revision();
 	const auto &brokenCommits =
-	    skipBrokenCommit ? hlp::getBrokenCommits(m_repo, verbose) : emptySet;
+	    skipBrokenCommit ? hlp::getBrokenCommits(m_repo, revision, verbose) : emptySet;
 
 	const auto headerLineRange = m_headerRangeOpt.has_value()
-	    ? hlp::headerLineRange(m_content.data(), m_headerRangeOpt.value())
+	    ? hlp::headerLineRange(contentView(), m_headerRangeOpt.value())
 	    : std::pair(0ull, 0ull);
 
-	auto candidates = hlp::collectGitBlameStatistic(m_repo, m_ctx.targetPath, brokenCommits,
-	                                                headerLineRange, authorAliases);
+	if (!m_blame.has_value()) {
+		const auto blameStartNsecs = profiler::nowNsecs();
+		auto blame = m_repo.blameFile(m_ctx.targetPath, revision);
+		const auto blameEndNsecs = profiler::nowNsecs();
+		profiler::traceSpan(profiler::Blame, blameStartNsecs, blameEndNsecs);
+		setBlame(std::move(blame), blameEndNsecs - blameStartNsecs);
+	}
+	const auto &blame = m_blame.value();
+
+	auto candidates =
+	    hlp::collectGitBlameStatistic(blame, brokenCommits, headerLineRange, authorAliases);
+
+	m_stats.authorShares.assign(candidates.cbegin(), candidates.cend());
+	std::sort(m_stats.authorShares.begin(), m_stats.authorShares.end(),
+	          [](const auto &l, const auto &r) { return l.second > r.second; });
+
+	const profiler::ScopedTimer timer(profiler::ListAuthors);
 	return hlp::listGitAuthors(std::move(candidates));
 }
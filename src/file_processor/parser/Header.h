@@ -1,8 +1,9 @@
 #pragma once
 
-#include <any>
-#include <QRegularExpression>
+#include <array>
+#include <optional>
 #include <QString>
+#include <variant>
 #include <vector>
 
 #include "header_fields.h"
@@ -14,24 +15,55 @@ struct Header
 {
 	using FieldValue = QString;
 	using FieldList = std::vector<FieldValue>;
+	// Parsed, but not decoded values, that point to the file content. They are decoded only when
+	// the field is compared, otherwise they are serialized as is.
+	using RawFieldValue = std::string_view;
+	using RawFieldList = std::vector<RawFieldValue>;
+	using Field = std::variant<std::monostate, FieldValue, FieldList, RawFieldValue, RawFieldList>;
 	using HeaderFieldType = header_fields::FieldType;
 
+	struct Stats
+	{
+		std::vector<HeaderFieldType> changedFields;
+		std::vector<std::pair<QString, double>> authorShares;  // Sorted by share, descending.
+		std::size_t blameLineCount = 0;
+		qint64 blameNsecs = 0;
+	};
+
 	Header(const Context &ctx, const QByteArray &content, GitRepository repo) noexcept;
 
 	void load();
 	void parse();
 	bool fix();
+	// fix() in two steps, so the blame can be awaited between them and given with setBlame().
+	// Without it, fixAuthors() blames the file itself.
+	bool fixFields();
+	[[nodiscard]] bool needsBlame() const;
+	void setBlame(GitBlame blame, qint64 blameNsecs);
+	bool fixAuthors();
+	// Exact number of bytes written by serialize().
+	[[nodiscard]] std::size_t serializedSize() const;
+	// Writes the header to 'out', that should have at least serializedSize() bytes, and returns
+	// pointer past the last written byte.
+	char *serialize(char *out) const;
 	[[nodiscard]] QByteArray serialize() const;
+	// Number of content bytes, that are replaced by the serialized header.
+	[[nodiscard]] std::size_t headerEndOffset() const;
+	// Points to the original content, that should outlive the result.
 	[[nodiscard]] QByteArray contentWithoutHeader() const;
 
 	constexpr bool isEmpty() noexcept { return m_rawHeader.empty(); }
+	// Prefix of the header is found, but its suffix is not, e.g. the header ends after the read
+	// part of the content.
+	[[nodiscard]] bool isUnterminated() const noexcept { return m_isUnterminated; }
+	[[nodiscard]] const Stats &stats() const noexcept { return m_stats; }
 
 private:
-	void initRegex();
+	[[nodiscard]] std::string_view contentView() const;
+	void initMarkers();
 	void parseField(std::string_view rawField);
-	bool fixField(HeaderFieldType type, std::any valueAny);
-	[[nodiscard]] bool shouldFixListField(HeaderFieldType type, const FieldList &value) const;
-	[[nodiscard]] bool shouldFixValueField(HeaderFieldType type, const FieldValue &value) const;
+	void decodeField(HeaderFieldType type);
+	bool fixField(HeaderFieldType type, Field value);
 	[[nodiscard]] bool mayUpdateAuthors() const;
 	[[nodiscard]] std::vector<QString> getAuthors();
 
@@ -39,7 +71,6 @@ private:
 	const Context &m_ctx;
 	const QByteArray &m_content;
 	GitRepository m_repo;
-	QRegularExpression m_regex;
 	std::string m_ext;
 	std::string_view m_prefix;
 	std::string_view m_start;
@@ -47,5 +78,9 @@ private:
 
 	std::string_view m_rawHeader;
 	header_helpers::HeaderRangeOpt m_headerRangeOpt;
-	std::unordered_map<HeaderFieldType, std::any> m_fields;
+	std::array<Field, header_fields::FieldTypeCount> m_fields;  // Indexed by HeaderFieldType.
+	std::optional<GitBlame> m_blame;
+	bool m_hasChanges = false;
+	bool m_isUnterminated = false;
+	Stats m_stats;
 };
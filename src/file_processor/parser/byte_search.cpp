@@ -0,0 +1,286 @@
+#include "byte_search.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CN_BYTE_SEARCH_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CN_TARGET_AVX2
+#else
+#define CN_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CN_BYTE_SEARCH_SSE2
+#endif
+
+namespace {
+
+constexpr auto npos = std::string_view::npos;
+
+int countTrailingZeros(std::uint32_t mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return static_cast<int>(index);
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+// Checks candidates, which first and last bytes are already known to match the needle.
+std::size_t findCandidate(const char *block, std::uint32_t mask, std::string_view needle)
+{
+	while (mask != 0) {
+		const int offset = countTrailingZeros(mask);
+		if (std::memcmp(block + offset + 1, needle.data() + 1, needle.size() - 2) == 0) {
+			return static_cast<std::size_t>(offset);
+		}
+		mask &= mask - 1;
+	}
+	return npos;
+}
+
+#ifdef CN_BYTE_SEARCH_X86
+
+bool isAvx2Supported()
+{
+#ifdef _MSC_VER
+	std::array<int, 4> info{};
+	__cpuid(info.data(), 0);
+	if (info[0] < 7) {
+		return false;
+	}
+
+	__cpuid(info.data(), 1);
+	constexpr int osxsaveBit = 1 << 27;
+	constexpr int avxBit = 1 << 28;
+	if ((info[2] & osxsaveBit) == 0 || (info[2] & avxBit) == 0) {
+		return false;
+	}
+
+	// OS must save YMM registers on context switch.
+	constexpr unsigned long long ymmStateMask = 0x6;
+	if ((_xgetbv(0) & ymmStateMask) != ymmStateMask) {
+		return false;
+	}
+
+	__cpuidex(info.data(), 7, 0);
+	constexpr int avx2Bit = 1 << 5;
+	return (info[1] & avx2Bit) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+const bool gIsAvx2Supported = isAvx2Supported();
+
+// Compares first and last bytes of the needle with 32 positions at once and checks the rest only
+// for positions, where both of them match (http://0x80.pl/articles/simd-strfind.html).
+CN_TARGET_AVX2 std::size_t findAvx2(std::string_view haystack, std::string_view needle)
+{
+	constexpr std::size_t blockSize = sizeof(__m256i);
+	const auto *data = haystack.data();
+	const std::size_t lastOffset = needle.size() - 1;
+
+	const __m256i first = _mm256_set1_epi8(needle.front());
+	const __m256i last = _mm256_set1_epi8(needle.back());
+
+	std::size_t pos = 0;
+	for (; pos + lastOffset + blockSize <= haystack.size(); pos += blockSize) {
+		const auto *firstPtr = reinterpret_cast<const __m256i *>(data + pos);
+		const auto *lastPtr = reinterpret_cast<const __m256i *>(data + pos + lastOffset);
+		const __m256i eqFirst = _mm256_cmpeq_epi8(first, _mm256_loadu_si256(firstPtr));
+		const __m256i eqLast = _mm256_cmpeq_epi8(last, _mm256_loadu_si256(lastPtr));
+		const auto mask =
+		    static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(eqFirst, eqLast)));
+
+		const auto found = findCandidate(data + pos, mask, needle);
+		if (found != npos) {
+			return pos + found;
+		}
+	}
+
+	return haystack.find(needle, pos);
+}
+
+// Matches are accumulated in 8-bit lanes (comparison result is -1 for a match) and summed up by
+// _mm256_sad_epu8 before any lane may overflow.
+CN_TARGET_AVX2 std::size_t countAvx2(std::string_view haystack, char byte)
+{
+	constexpr std::size_t blockSize = sizeof(__m256i);
+	constexpr std::size_t maxBlocksPerFlush = 255;
+	const auto *data = haystack.data();
+	const __m256i pattern = _mm256_set1_epi8(byte);
+	const __m256i zero = _mm256_setzero_si256();
+
+	__m256i total = zero;
+	std::size_t pos = 0;
+	while (pos + blockSize <= haystack.size()) {
+		const std::size_t blockCount =
+		    std::min((haystack.size() - pos) / blockSize, maxBlocksPerFlush);
+		__m256i laneCounts = zero;
+		for (std::size_t i = 0; i < blockCount; ++i, pos += blockSize) {
+			const auto *blockPtr = reinterpret_cast<const __m256i *>(data + pos);
+			const __m256i eq = _mm256_cmpeq_epi8(pattern, _mm256_loadu_si256(blockPtr));
+			laneCounts = _mm256_sub_epi8(laneCounts, eq);
+		}
+		total = _mm256_add_epi64(total, _mm256_sad_epu8(laneCounts, zero));
+	}
+
+	std::array<std::uint64_t, 4> sums{};
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(sums.data()), total);
+	const auto tail = haystack.substr(pos);
+	return static_cast<std::size_t>(sums[0] + sums[1] + sums[2] + sums[3])
+	    + static_cast<std::size_t>(std::count(tail.cbegin(), tail.cend(), byte));
+}
+
+#endif  // CN_BYTE_SEARCH_X86
+
+#ifdef CN_BYTE_SEARCH_SSE2
+
+std::size_t findSse2(std::string_view haystack, std::string_view needle)
+{
+	constexpr std::size_t blockSize = sizeof(__m128i);
+	const auto *data = haystack.data();
+	const std::size_t lastOffset = needle.size() - 1;
+
+	const __m128i first = _mm_set1_epi8(needle.front());
+	const __m128i last = _mm_set1_epi8(needle.back());
+
+	std::size_t pos = 0;
+	for (; pos + lastOffset + blockSize <= haystack.size(); pos += blockSize) {
+		const auto *firstPtr = reinterpret_cast<const __m128i *>(data + pos);
+		const auto *lastPtr = reinterpret_cast<const __m128i *>(data + pos + lastOffset);
+		const __m128i eqFirst = _mm_cmpeq_epi8(first, _mm_loadu_si128(firstPtr));
+		const __m128i eqLast = _mm_cmpeq_epi8(last, _mm_loadu_si128(lastPtr));
+		const auto mask =
+		    static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_and_si128(eqFirst, eqLast)));
+
+		const auto found = findCandidate(data + pos, mask, needle);
+		if (found != npos) {
+			return pos + found;
+		}
+	}
+
+	return haystack.find(needle, pos);
+}
+
+std::size_t countSse2(std::string_view haystack, char byte)
+{
+	constexpr std::size_t blockSize = sizeof(__m128i);
+	constexpr std::size_t maxBlocksPerFlush = 255;
+	const auto *data = haystack.data();
+	const __m128i pattern = _mm_set1_epi8(byte);
+	const __m128i zero = _mm_setzero_si128();
+
+	__m128i total = zero;
+	std::size_t pos = 0;
+	while (pos + blockSize <= haystack.size()) {
+		const std::size_t blockCount =
+		    std::min((haystack.size() - pos) / blockSize, maxBlocksPerFlush);
+		__m128i laneCounts = zero;
+		for (std::size_t i = 0; i < blockCount; ++i, pos += blockSize) {
+			const auto *blockPtr = reinterpret_cast<const __m128i *>(data + pos);
+			const __m128i eq = _mm_cmpeq_epi8(pattern, _mm_loadu_si128(blockPtr));
+			laneCounts = _mm_sub_epi8(laneCounts, eq);
+		}
+		total = _mm_add_epi64(total, _mm_sad_epu8(laneCounts, zero));
+	}
+
+	std::array<std::uint64_t, 2> sums{};
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(sums.data()), total);
+	const auto tail = haystack.substr(pos);
+	return static_cast<std::size_t>(sums[0] + sums[1])
+	    + static_cast<std::size_t>(std::count(tail.cbegin(), tail.cend(), byte));
+}
+
+#endif  // CN_BYTE_SEARCH_SSE2
+
+}  // namespace
+
+namespace byte_search {
+
+std::size_t find(std::string_view haystack, std::string_view needle) noexcept
+{
+#ifdef CN_BYTE_SEARCH_X86
+	if (gIsAvx2Supported) {
+		return find(haystack, needle, Isa::Avx2);
+	}
+#endif
+
+#ifdef CN_BYTE_SEARCH_SSE2
+	return find(haystack, needle, Isa::Sse2);
+#else
+	return find(haystack, needle, Isa::Scalar);
+#endif
+}
+
+std::size_t count(std::string_view haystack, char byte) noexcept
+{
+#ifdef CN_BYTE_SEARCH_X86
+	if (gIsAvx2Supported) {
+		return count(haystack, byte, Isa::Avx2);
+	}
+#endif
+
+#ifdef CN_BYTE_SEARCH_SSE2
+	return count(haystack, byte, Isa::Sse2);
+#else
+	return count(haystack, byte, Isa::Scalar);
+#endif
+}
+
+bool isSupported(Isa isa) noexcept
+{
+	switch (isa) {
+	case Isa::Scalar: return true;
+#ifdef CN_BYTE_SEARCH_SSE2
+	case Isa::Sse2: return true;
+#endif
+#ifdef CN_BYTE_SEARCH_X86
+	case Isa::Avx2: return gIsAvx2Supported;
+#endif
+	default: return false;
+	}
+}
+
+std::size_t find(std::string_view haystack, std::string_view needle, Isa isa) noexcept
+{
+	// Single byte needles are handled by memchr, which is vectorized by the standard library.
+	if (needle.size() < 2 || needle.size() > haystack.size()) {
+		return haystack.find(needle);
+	}
+
+	switch (isa) {
+#ifdef CN_BYTE_SEARCH_X86
+	case Isa::Avx2: return findAvx2(haystack, needle);
+#endif
+#ifdef CN_BYTE_SEARCH_SSE2
+	case Isa::Sse2: return findSse2(haystack, needle);
+#endif
+	default: return haystack.find(needle);
+	}
+}
+
+std::size_t count(std::string_view haystack, char byte, Isa isa) noexcept
+{
+	switch (isa) {
+#ifdef CN_BYTE_SEARCH_X86
+	case Isa::Avx2: return countAvx2(haystack, byte);
+#endif
+#ifdef CN_BYTE_SEARCH_SSE2
+	case Isa::Sse2: return countSse2(haystack, byte);
+#endif
+	default: return static_cast<std::size_t>(std::count(haystack.cbegin(), haystack.cend(), byte));
+	}
+}
+
+}  // namespace byte_search
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string_view>
+
+// Byte search primitives for header lookup. They use AVX2 or SSE2 when the CPU supports them and
+// fall back to the standard library otherwise.
+namespace byte_search {
+
+// Returns position of the first occurrence of 'needle' in 'haystack' or std::string_view::npos.
+[[nodiscard]] std::size_t find(std::string_view haystack, std::string_view needle) noexcept;
+
+// Returns number of 'byte' occurrences in 'haystack'.
+[[nodiscard]] std::size_t count(std::string_view haystack, char byte) noexcept;
+
+// Implementations, which find() and count() select from, to test each of them on any CPU.
+enum class Isa { Scalar, Sse2, Avx2 };
+
+[[nodiscard]] bool isSupported(Isa isa) noexcept;
+// 'isa' should be supported.
+[[nodiscard]] std::size_t find(std::string_view haystack, std::string_view needle,
+                               Isa isa) noexcept;
+[[nodiscard]] std::size_t count(std::string_view haystack, char byte, Isa isa) noexcept;
+
+}  // namespace byte_search
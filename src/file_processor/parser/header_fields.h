@@ -1,6 +1,8 @@
 #pragma once
 
+#include <array>
 #include <QString>
+#include <string_view>
 
 #include "src/constants.h"
 
@@ -24,19 +26,26 @@ inline int currentYear()
 
 }  // namespace impl
 
-static const QLatin1String allWithSeparator("File|Author|Copyright|This file is part of");
-
 // FieldType Also is order, using which fields will be serialized
-enum FieldType { File, Author, Copyright, Component, Default = 100 };
+enum FieldType { File, Author, Copyright, Component, FieldTypeCount, Default = 100 };
 
+// Field names as they are met in not decoded header lines.
 // clang-format off
-inline FieldType toFieldType(const QString &fieldName)
+constexpr std::array<std::pair<std::string_view, FieldType>, 4> rawFieldNames{{
+    {"File", FieldType::File},
+    {"Author", FieldType::Author},
+    {"Copyright", FieldType::Copyright},
+    {"This file is part of", FieldType::Component},
+}};
+
+constexpr std::string_view toRawFieldName(FieldType fieldType)
 {
-	if (fieldName == impl::file) { return FieldType::File; }
-	if (fieldName == impl::author) { return FieldType::Author; }
-	if (fieldName == impl::copyright) { return FieldType::Copyright; }
-	if (fieldName == impl::component) { return FieldType::Component; }
-	return Default;
+	for (const auto &[name, type] : rawFieldNames) {
+		if (type == fieldType) {
+			return name;
+		}
+	}
+	return {};
 }
 
 inline QString toFieldName(FieldType fieldType)
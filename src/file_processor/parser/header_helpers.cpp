@@ -4,38 +4,68 @@
 #include <QRegularExpression>
 #include <QStringBuilder>
 
-#include "src/file_processor/git/GitBlameLine.h"
+#include "src/file_processor/git/GitBlame.h"
 #include "src/logger/log.h"
+#include "src/profiler/profiler.h"
+
+#include "byte_search.h"
 
 namespace {
 
-std::unique_ptr<std::set<QString>> gBrokenCommitsInstance;
-std::once_flag create;
+// Broken commits of every repository are collected once, by the first file, that needs them.
+struct BrokenCommits
+{
+	std::once_flag isCollected;
+	std::set<QString> commits;
+};
+
+std::mutex gBrokenCommitsMutex;
+std::unordered_map<QString, std::unique_ptr<BrokenCommits>> gBrokenCommits;
 
 }  // namespace
 
 namespace header_helpers {
 
 HeaderRangeOpt headerRange(std::string_view content, std::string_view prefix,
-                           std::string_view suffix)
+                           std::string_view suffix, std::size_t maxHeaderOffset)
 {
-	const auto stItr = std::search(content.begin(), content.end(), prefix.begin(), prefix.end());
-	if (stItr == content.end()) {
+	const auto prefixPos = findHeaderStart(content, prefix, maxHeaderOffset);
+	if (prefixPos == std::string_view::npos) {
 		return std::nullopt;
 	}
 
-	auto endItr = std::search(content.begin(), content.end(), suffix.begin(), suffix.end());
-	if (endItr == content.end()) {
+	// Header without fields shares the last prefix character with the suffix (see
+	// Header::serialize), that is why the suffix is searched starting from this character.
+	const bool mayOverlap = !prefix.empty() && !suffix.empty() && prefix.back() == suffix.front();
+	const auto suffixSearchPos = prefixPos + prefix.size() - (mayOverlap ? 1 : 0);
+	const auto suffixPos = byte_search::find(content.substr(suffixSearchPos), suffix);
+	if (suffixPos == std::string_view::npos) {
 		return std::nullopt;
 	}
 
-	std::advance(endItr, suffix.size());
+	const auto headerEndPos = suffixSearchPos + suffixPos + suffix.size();
+	const auto stItr = std::next(content.begin(), static_cast<std::ptrdiff_t>(prefixPos));
+	const auto endItr = std::next(content.begin(), static_cast<std::ptrdiff_t>(headerEndPos));
 	return std::pair{stItr, endItr};
 }
 
+std::size_t findHeaderStart(std::string_view content, std::string_view prefix,
+                            std::size_t maxHeaderOffset)
+{
+	// Only the prefix position is limited, the header itself may cross the offset. Prefix longer
+	// than one byte is still found, if it starts just before the offset.
+	const auto prefixArea = maxHeaderOffset > 0
+	    ? content.substr(0, maxHeaderOffset + (prefix.empty() ? 0 : prefix.size() - 1))
+	    : content;
+	return byte_search::find(prefixArea, prefix);
+}
+
 std::vector<std::string_view> splitString(std::string_view str, std::string_view delimiter)
 {
 	std::vector<std::string_view> strings;
+	if (delimiter.size() == 1) {
+		strings.reserve(byte_search::count(str, delimiter.front()) + 1);
+	}
 
 	std::size_t pos;
 	std::size_t prev{};
@@ -50,39 +80,111 @@ std::vector<std::string_view> splitString(std::string_view str, std::string_view
 	return strings;
 }
 
+std::size_t utf8Size(QStringView str) noexcept
+{
+	std::size_t size = 0;
+	for (qsizetype i = 0; i < str.size(); ++i) {
+		const char16_t ch = str[i].unicode();
+		if (ch < 0x80) {
+			size += 1;
+		} else if (ch < 0x800) {
+			size += 2;
+		} else if (QChar::isHighSurrogate(ch) && i + 1 < str.size()
+		           && QChar::isLowSurrogate(str[i + 1].unicode())) {
+			size += 4;
+			++i;
+		} else {
+			size += 3;
+		}
+	}
+	return size;
+}
+
+char *writeUtf8(QStringView str, char *out) noexcept
+{
+	const auto put = [&out](unsigned value) { *out++ = static_cast<char>(value); };
+
+	for (qsizetype i = 0; i < str.size(); ++i) {
+		char32_t ch = str[i].unicode();
+		if (ch < 0x80) {
+			put(ch);
+		} else if (ch < 0x800) {
+			put(0xC0 | (ch >> 6));
+			put(0x80 | (ch & 0x3F));
+		} else if (QChar::isHighSurrogate(ch) && i + 1 < str.size()
+		           && QChar::isLowSurrogate(str[i + 1].unicode())) {
+			ch = QChar::surrogateToUcs4(static_cast<char16_t>(ch), str[++i].unicode());
+			put(0xF0 | (ch >> 18));
+			put(0x80 | ((ch >> 12) & 0x3F));
+			put(0x80 | ((ch >> 6) & 0x3F));
+			put(0x80 | (ch & 0x3F));
+		} else {
+			if (QChar::isSurrogate(ch)) {
+				ch = QChar::ReplacementCharacter;
+			}
+			put(0xE0 | (ch >> 12));
+			put(0x80 | ((ch >> 6) & 0x3F));
+			put(0x80 | (ch & 0x3F));
+		}
+	}
+	return out;
+}
+
 std::pair<size_t, size_t> headerLineRange(std::string_view content, const HeaderRange &headerRange)
 {
 	const auto beforeHeaderContent = std::string_view(content.begin(), headerRange.first);
 	const auto headerContent = getHeader(content, headerRange);
 
-	const auto beforeHeaderLineCount = splitString(beforeHeaderContent, "\n").size() - 1;
-	const auto headerLineCount = splitString(headerContent, "\n").size() - 1;
+	const auto beforeHeaderLineCount = byte_search::count(beforeHeaderContent, '\n');
+	const auto headerLineCount = byte_search::count(headerContent, '\n');
 	return {beforeHeaderLineCount, beforeHeaderLineCount + headerLineCount};
 }
 
 std::unordered_map<QString, double> collectGitBlameStatistic(
-    const GitRepository &repo, const QString &filePath, const std::set<QString> &skipCommits,
+    const GitBlame &blame, const std::set<QString> &skipCommits,
     const std::pair<size_t, size_t> &headerLineRange, const AuthorAliasesMap &authorAliases)
 {
-	const auto blame = repo.blameFile(filePath);
-
-	const size_t lastHeaderLine = headerLineRange.second;
-	auto stItr = blame.cbegin();
+	const size_t lastHeaderLine = std::min(headerLineRange.second, blame.lines.size());
+	auto stItr = blame.lines.cbegin();
 	std::advance(stItr, lastHeaderLine);
 
-	std::unordered_map<QString, double> authorScore;
+	std::vector<std::size_t> commitLineCount(blame.commits.size());
+	std::for_each(stItr, blame.lines.cend(),
+	              [&commitLineCount](GitBlame::Id commitId) { ++commitLineCount[commitId]; });
+
+	// Skip status and aliases are resolved once per distinct commit and author.
+	std::vector<std::size_t> authorLineCount(blame.authors.size());
 	double blameSum = 0;
+	for (GitBlame::Id commitId = 0; commitId < commitLineCount.size(); ++commitId) {
+		const auto lineCount = commitLineCount[commitId];
+		if (lineCount == 0) {
+			continue;
+		}
 
-	std::for_each(stItr, blame.cend(), [&](const GitBlameLine &line) {
-		if (skipCommits.end() != skipCommits.find(line.hash)) {
-			CN_DEBUG("Skipping commit " << line.hash);
-			return;
+		const auto &hash = blame.commits[commitId];
+		// Author of uncommitted lines is not known, until they are committed.
+		if (hash == GitBlame::cUncommittedHash) {
+			continue;
+		}
+		if (skipCommits.end() != skipCommits.find(hash)) {
+			CN_DEBUG("Skipping commit " << hash);
+			continue;
 		}
 
-		QString key = getOrDefault(authorAliases, line.author, line.author);
-		authorScore[key] += 1.0;
-		blameSum += 1.0;
-	});
+		authorLineCount[blame.commitAuthors[commitId]] += lineCount;
+		blameSum += static_cast<double>(lineCount);
+	}
+
+	std::unordered_map<QString, double> authorScore;
+	for (GitBlame::Id authorId = 0; authorId < authorLineCount.size(); ++authorId) {
+		if (authorLineCount[authorId] == 0) {
+			continue;
+		}
+
+		const auto &author = blame.authors[authorId];
+		const QString &key = getOrDefault(authorAliases, author, author);
+		authorScore[key] += static_cast<double>(authorLineCount[authorId]);
+	}
 
 	// Normalize values
 	for (auto &[key, value] : authorScore) {
@@ -161,6 +263,10 @@ std::vector<QString> listGitAuthors(std::unordered_map<QString, double> blameCan
 
 [[maybe_unused]] void logBrokenCommits(const auto &brokenCommits)
 {
+	if (!logger::isEnabled(logger::Level::Debug)) {
+		return;
+	}
+
 	QString msg("Will skip the following commits when blaming: ");
 	for (const auto &hash : brokenCommits) {
 		msg = msg % hash % ", ";
@@ -168,18 +274,29 @@ std::vector<QString> listGitAuthors(std::unordered_map<QString, double> blameCan
 	CN_DEBUG(msg);
 }
 
-const std::set<QString> &getBrokenCommits(const GitRepository &repo, bool verbose)
+const std::set<QString> &getBrokenCommits(const GitRepository &repo, const QString &revision,
+                                          bool verbose)
 {
-	std::call_once(create, [&repo, verbose] {
-		auto commitsVec = repo.getBrokenCommits();
-		auto commitsSet = std::set<QString>(commitsVec.begin(), commitsVec.end());
-		gBrokenCommitsInstance = std::make_unique<std::set<QString>>(std::move(commitsSet));
+	BrokenCommits *brokenCommits{};
+	{
+		std::lock_guard l(gBrokenCommitsMutex);
+		auto &repoCommits = gBrokenCommits[repo.getWorkingTreeDir()];
+		if (!repoCommits) {
+			repoCommits = std::make_unique<BrokenCommits>();
+		}
+		brokenCommits = repoCommits.get();
+	}
+
+	std::call_once(brokenCommits->isCollected, [&repo, &revision, brokenCommits, verbose] {
+		const profiler::ScopedTimer timer(profiler::BrokenCommits);
+		auto commitsVec = repo.getBrokenCommits(revision);
+		brokenCommits->commits = std::set<QString>(commitsVec.begin(), commitsVec.end());
 
 		if (verbose) {
 			// logBrokenCommits(commitsVec);
 		}
 	});
-	return *gBrokenCommitsInstance;
+	return brokenCommits->commits;
 }
 
 }  // namespace header_helpers
\ No newline at end of file
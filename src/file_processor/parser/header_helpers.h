@@ -6,16 +6,25 @@
 
 #include "src/configuration/RunConfig.h"
 #include "src/configuration/StaticConfig.h"
+#include "src/file_processor/git/GitBlame.h"
 #include "src/file_processor/git/GitRepository.h"
 
+#include "header_fields.h"
+
 namespace header_helpers {
 
 using StringViewIterator = std::string_view::iterator;
 using HeaderRange = std::pair<StringViewIterator, StringViewIterator>;
 using HeaderRangeOpt = std::optional<std::pair<StringViewIterator, StringViewIterator>>;
 
+// Header must start within 'maxHeaderOffset' bytes from the content start (0 means no limit), so
+// content without header is rejected after scanning only this part of it.
 HeaderRangeOpt headerRange(std::string_view content, std::string_view prefix,
-                           std::string_view suffix);
+                           std::string_view suffix, std::size_t maxHeaderOffset = 0);
+// Position of the prefix, that headerRange() starts the header at, or npos. The header is not
+// found, if its suffix is not found after it.
+std::size_t findHeaderStart(std::string_view content, std::string_view prefix,
+                            std::size_t maxHeaderOffset = 0);
 
 constexpr std::string_view getHeader(std::string_view content, const auto &headerRange)
 {
@@ -48,8 +57,52 @@ constexpr std::string_view findHeaderBody(std::string_view header, std::string_v
 	return header.substr(std::distance(header.begin(), stBodyIt), bodySize);
 }
 
+struct FieldToken
+{
+	header_fields::FieldType type = header_fields::FieldType::Default;  // Default if no field.
+	std::string_view value;
+};
+
+// Splits header line '<start> <field name> <value>' without decoding it. Line, that consists only
+// of '<start>', has no field. Returns std::nullopt if the line does not match the format.
+constexpr std::optional<FieldToken> tokenizeField(std::string_view line, std::string_view start)
+{
+	if (!line.starts_with(start)) {
+		return std::nullopt;
+	}
+
+	line.remove_prefix(start.size());
+	if (line.empty()) {
+		return FieldToken{};
+	}
+
+	if (line.front() != ' ') {
+		return std::nullopt;
+	}
+	line.remove_prefix(1);
+
+	for (const auto &[name, type] : header_fields::rawFieldNames) {
+		if (line.size() <= name.size() || !line.starts_with(name) || line[name.size()] != ' ') {
+			continue;
+		}
+
+		const auto valuePos = line.find_first_not_of(' ', name.size());
+		const auto value = valuePos == std::string_view::npos ? std::string_view()
+		                                                      : line.substr(valuePos);
+		return FieldToken{type, value};
+	}
+
+	return std::nullopt;
+}
+
 std::vector<std::string_view> splitString(std::string_view str, std::string_view delimiter);
 
+// Size of the UTF-8 representation of 'str', unpaired surrogates are counted as U+FFFD.
+std::size_t utf8Size(QStringView str) noexcept;
+// Writes UTF-8 representation of 'str' to 'out', that should have at least utf8Size(str) bytes.
+// Returns pointer past the last written byte.
+char *writeUtf8(QStringView str, char *out) noexcept;
+
 std::pair<size_t, size_t> headerLineRange(std::string_view content, const HeaderRange &headerRange);
 
 constexpr auto &getOrDefault(const auto &map, const auto &key, const auto &defaultValue)
@@ -59,7 +112,7 @@ constexpr auto &getOrDefault(const auto &map, const auto &key, const auto &defau
 }
 
 std::unordered_map<QString, double> collectGitBlameStatistic(
-    const GitRepository &repo, const QString &filePath, const std::set<QString> &skipCommits,
+    const GitBlame &blame, const std::set<QString> &skipCommits,
     const std::pair<size_t, size_t> &headerLineRange, const AuthorAliasesMap &authorAliases);
 
 struct FilteredAuthors
@@ -73,6 +126,9 @@ FilteredAuthors filterAuthors(const std::unordered_map<QString, double> &authors
 std::vector<QString> listGitAuthors(std::unordered_map<QString, double> blameCandidates,
                                     std::unordered_map<QString, double> logCandidates = {});
 
-const std::set<QString> &getBrokenCommits(const GitRepository &repo, bool verbose);
+// Broken commits are collected once per repository from the history of 'revision', which is the
+// same for all files of the run.
+const std::set<QString> &getBrokenCommits(const GitRepository &repo, const QString &revision,
+                                          bool verbose);
 
 }  // namespace header_helpers
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "PatchWriter.h"
+
+#include <algorithm>
+
+#include "src/logger/log.h"
+
+PatchWriter::PatchWriter(const QString &path, std::vector<QString> filePaths)
+    : m_file(path)
+    , m_diffs(filePaths.size())
+{
+	if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		CN_ERR(logger::MsgCode::BadPatch,
+		       "Error opening patch " << path << ": " << m_file.errorString());
+		throw std::exception();
+	}
+
+	std::sort(filePaths.begin(), filePaths.end());
+	for (std::size_t i = 0; i < filePaths.size(); i++) {
+		m_positions.emplace(std::move(filePaths[i]), i);
+	}
+}
+
+void PatchWriter::write(const QString &filePath, QByteArray diff)
+{
+	std::lock_guard l(m_mutex);
+
+	const auto itr = m_positions.find(filePath);
+	if (itr == m_positions.cend()) {
+		return;
+	}
+	m_diffs[itr->second] = std::move(diff);
+
+	for (; m_nextPosition < m_diffs.size() && m_diffs[m_nextPosition]; m_nextPosition++) {
+		writeDiff(*m_diffs[m_nextPosition]);
+		m_diffs[m_nextPosition].reset();
+	}
+}
+
+void PatchWriter::close()
+{
+	std::lock_guard l(m_mutex);
+
+	for (; m_nextPosition < m_diffs.size(); m_nextPosition++) {
+		if (m_diffs[m_nextPosition]) {
+			writeDiff(*m_diffs[m_nextPosition]);
+		}
+	}
+	m_diffs.clear();
+
+	if (!m_file.flush()) {
+		onError();
+	}
+	m_file.close();
+}
+
+void PatchWriter::writeDiff(const QByteArray &diff)
+{
+	if (m_file.write(diff) != diff.size()) {
+		onError();
+	}
+}
+
+void PatchWriter::onError()
+{
+	// Patch is not complete, but files are still processed, like without it.
+	if (!m_isFailed) {
+		m_isFailed = true;
+		CN_ERR(logger::MsgCode::BadPatch,
+		       "Error writing patch " << m_file.fileName() << ": " << m_file.errorString());
+	}
+}
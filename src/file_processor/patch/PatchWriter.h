@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QFile>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+// Writes diffs of all files into one patch in the order of their paths. Diff is written, as soon as
+// diffs of all files before it are written, so the patch does not depend on the number of jobs, and
+// only diffs, that are finished out of order, are kept in memory.
+struct PatchWriter
+{
+	PatchWriter(const QString &path, std::vector<QString> filePaths);
+	PatchWriter(const PatchWriter &) = delete;
+
+	// Must be called for every file of the patch, with empty 'diff', if it is not changed.
+	void write(const QString &filePath, QByteArray diff);
+
+	// Writes remaining diffs, that wait for files, which were not processed, e.g. after cancel.
+	void close();
+
+private:
+	void writeDiff(const QByteArray &diff);
+	void onError();
+
+private:
+	QFile m_file;
+	std::mutex m_mutex;
+	std::unordered_map<QString, std::size_t> m_positions;
+	std::vector<std::optional<QByteArray>> m_diffs;
+	std::size_t m_nextPosition = 0;
+	bool m_isFailed = false;
+};
@@ -0,0 +1,251 @@
+#include "patch_helpers.h"
+
+#include <algorithm>
+#include <string_view>
+#include <vector>
+
+#include "src/logger/log.h"
+
+namespace {
+
+using Msg = logger::MsgCode;
+
+// Same number of context lines, as in 'git diff'.
+constexpr std::size_t cContextLines = 3;
+// Larger changed regions are not minimized, all their lines are replaced.
+constexpr std::size_t cMaxLcsCells = 4 * 1024 * 1024;
+
+// Lines keep their '\n', only the last line of the file may have none.
+using Lines = std::vector<std::string_view>;
+
+struct Edit
+{
+	char op;  // ' ', '-' or '+'.
+	std::string_view line;
+};
+
+void appendLines(std::string_view text, Lines &lines)
+{
+	while (!text.empty()) {
+		const auto end = text.find('\n');
+		const auto size = end == std::string_view::npos ? text.size() : end + 1;
+		lines.emplace_back(text.substr(0, size));
+		text.remove_prefix(size);
+	}
+}
+
+// Appends edits, that turn 'from' into 'to', with the longest common subsequence of lines.
+void appendEdits(const Lines &from, const Lines &to, std::vector<Edit> &edits)
+{
+	const auto n = from.size();
+	const auto m = to.size();
+	if (n * m > cMaxLcsCells) {
+		for (const auto line : from) {
+			edits.push_back({'-', line});
+		}
+		for (const auto line : to) {
+			edits.push_back({'+', line});
+		}
+		return;
+	}
+
+	// Length of the common subsequence of the suffixes, that start at i and j.
+	std::vector<std::size_t> lcs((n + 1) * (m + 1), 0);
+	const auto at = [m, &lcs](std::size_t i, std::size_t j) -> std::size_t & {
+		return lcs[i * (m + 1) + j];
+	};
+	for (auto i = n; i-- > 0;) {
+		for (auto j = m; j-- > 0;) {
+			at(i, j) = from[i] == to[j] ? at(i + 1, j + 1) + 1
+			                            : std::max(at(i + 1, j), at(i, j + 1));
+		}
+	}
+
+	std::size_t i = 0;
+	std::size_t j = 0;
+	while (i < n || j < m) {
+		if (i < n && j < m && from[i] == to[j]) {
+			edits.push_back({' ', from[i++]});
+			j++;
+		} else if (j == m || (i < n && at(i + 1, j) >= at(i, j + 1))) {
+			edits.push_back({'-', from[i++]});
+		} else {
+			edits.push_back({'+', to[j++]});
+		}
+	}
+}
+
+std::vector<Edit> makeEdits(const Lines &from, const Lines &to)
+{
+	std::size_t prefix = 0;
+	while (prefix < from.size() && prefix < to.size() && from[prefix] == to[prefix]) {
+		prefix++;
+	}
+	std::size_t suffix = 0;
+	while (suffix < from.size() - prefix && suffix < to.size() - prefix
+	       && from[from.size() - 1 - suffix] == to[to.size() - 1 - suffix]) {
+		suffix++;
+	}
+
+	std::vector<Edit> edits;
+	for (std::size_t i = 0; i < prefix; i++) {
+		edits.push_back({' ', from[i]});
+	}
+	appendEdits(Lines(from.begin() + prefix, from.end() - suffix),
+	            Lines(to.begin() + prefix, to.end() - suffix), edits);
+	for (auto i = from.size() - suffix; i < from.size(); i++) {
+		edits.push_back({' ', from[i]});
+	}
+	return edits;
+}
+
+QByteArray toRange(std::size_t start, std::size_t count)
+{
+	// Empty range starts at the line before it.
+	if (count == 0) {
+		return QByteArray::number(static_cast<qulonglong>(start - 1)) + ",0";
+	}
+	if (count == 1) {
+		return QByteArray::number(static_cast<qulonglong>(start));
+	}
+	return QByteArray::number(static_cast<qulonglong>(start)) + ','
+	    + QByteArray::number(static_cast<qulonglong>(count));
+}
+
+// Quotes the path like git does, if it has characters, that can not be written as is.
+QByteArray toDiffPath(const char *prefix, const QString &path)
+{
+	const auto utf8 = path.toUtf8();
+	const bool needsQuotes = std::any_of(utf8.cbegin(), utf8.cend(), [](char c) {
+		return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+	});
+	if (!needsQuotes) {
+		return prefix + utf8;
+	}
+
+	QByteArray quoted = QByteArray(1, '"') + prefix;
+	for (const char c : utf8) {
+		switch (c) {
+		case '"': quoted += "\\\""; break;
+		case '\\': quoted += "\\\\"; break;
+		case '\t': quoted += "\\t"; break;
+		case '\n': quoted += "\\n"; break;
+		default:
+			if (static_cast<unsigned char>(c) < 0x20) {
+				quoted += '\\' + QByteArray::number(static_cast<unsigned char>(c), 8)
+				                     .rightJustified(3, '0');
+			} else {
+				quoted += c;
+			}
+		}
+	}
+	return quoted + '"';
+}
+
+void appendHunks(const std::vector<Edit> &edits, const QByteArray &lineEnd, QByteArray &diff)
+{
+	// Changes, which context lines touch or overlap, are joined into one hunk.
+	std::vector<bool> isInHunk(edits.size(), false);
+	for (std::size_t i = 0; i < edits.size(); i++) {
+		if (edits[i].op == ' ') {
+			continue;
+		}
+		const auto first = i > cContextLines ? i - cContextLines : 0;
+		const auto last = std::min(i + cContextLines, edits.size() - 1);
+		std::fill(isInHunk.begin() + first, isInHunk.begin() + last + 1, true);
+	}
+
+	std::size_t fromLine = 1;
+	std::size_t toLine = 1;
+	for (std::size_t i = 0; i < edits.size();) {
+		if (!isInHunk[i]) {
+			fromLine++;
+			toLine++;
+			i++;
+			continue;
+		}
+
+		auto end = i;
+		std::size_t fromCount = 0;
+		std::size_t toCount = 0;
+		for (; end < edits.size() && isInHunk[end]; end++) {
+			fromCount += edits[end].op != '+';
+			toCount += edits[end].op != '-';
+		}
+
+		diff += "@@ -" + toRange(fromLine, fromCount) + " +" + toRange(toLine, toCount) + " @@\n";
+		for (; i < end; i++) {
+			const auto line = edits[i].line;
+			diff += edits[i].op;
+			if (line.back() == '\n') {
+				diff.append(line.data(), static_cast<int>(line.size() - 1));
+				diff += lineEnd;
+			} else {
+				diff.append(line.data(), static_cast<int>(line.size()));
+				diff += "\n\\ No newline at end of file\n";
+			}
+		}
+		fromLine += fromCount;
+		toLine += toCount;
+	}
+}
+
+}  // namespace
+
+namespace patch_helpers {
+
+QByteArray makeFileDiff(const QString &path, const QByteArray &content,
+                        std::size_t headerEndOffset, const QByteArray &newHeader, bool isWholeFile,
+                        const QByteArray &lineEnd)
+{
+	const std::string_view view(content.constData(), static_cast<std::size_t>(content.size()));
+
+	// Changed region ends with the line of the header end.
+	auto regionEnd = headerEndOffset;
+	if (regionEnd > 0 && view[regionEnd - 1] != '\n') {
+		regionEnd = view.find('\n', regionEnd);
+		if (regionEnd == std::string_view::npos) {
+			if (!isWholeFile) {
+				CN_ERR(Msg::InternalError, "Header of " << path << " ends after the read part.");
+				throw std::exception();
+			}
+			regionEnd = view.size();
+		} else {
+			regionEnd++;
+		}
+	}
+
+	Lines from;
+	Lines to;
+	appendLines(view.substr(0, regionEnd), from);
+	const auto newRegion = newHeader + content.mid(static_cast<int>(headerEndOffset),
+	                                               static_cast<int>(regionEnd - headerEndOffset));
+	appendLines({newRegion.constData(), static_cast<std::size_t>(newRegion.size())}, to);
+	if (from == to) {
+		return {};
+	}
+
+	// 'git apply' checks lines after the change, unless it is at the end of the file.
+	Lines context;
+	appendLines(view.substr(regionEnd), context);
+	if (context.size() > cContextLines) {
+		context.resize(cContextLines);
+	} else if (!isWholeFile && !context.empty() && context.back().back() != '\n') {
+		context.pop_back();
+	}
+	from.insert(from.end(), context.cbegin(), context.cend());
+	to.insert(to.end(), context.cbegin(), context.cend());
+
+	const auto fromPath = toDiffPath("a/", path);
+	const auto toPath = toDiffPath("b/", path);
+	// Tab marks the end of the name with spaces for 'git apply'.
+	const auto nameEnd = path.contains(' ') ? "\t\n" : "\n";
+
+	QByteArray diff = "diff --git " + fromPath + ' ' + toPath + '\n';
+	diff += "--- " + fromPath + nameEnd;
+	diff += "+++ " + toPath + nameEnd;
+	appendHunks(makeEdits(from, to), lineEnd, diff);
+	return diff;
+}
+
+}  // namespace patch_helpers
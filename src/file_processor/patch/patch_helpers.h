@@ -0,0 +1,17 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+namespace patch_helpers {
+
+// Returns unified diff of one file, that 'git apply' accepts, or empty array, if nothing changes.
+// First 'headerEndOffset' bytes of 'content' are replaced by 'newHeader'. 'content' is either the
+// whole file or its beginning, then context lines are taken only from complete lines. Lines are
+// written with 'lineEnd' instead of '\n', so the diff applies to the file, that 'content' was read
+// from without carriage returns.
+[[nodiscard]] QByteArray makeFileDiff(const QString &path, const QByteArray &content,
+                                      std::size_t headerEndOffset, const QByteArray &newHeader,
+                                      bool isWholeFile, const QByteArray &lineEnd = "\n");
+
+}  // namespace patch_helpers
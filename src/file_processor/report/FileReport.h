@@ -0,0 +1,22 @@
+#pragma once
+
+#include <array>
+#include <QString>
+#include <vector>
+
+#include "src/file_processor/parser/header_fields.h"
+
+struct FileReport
+{
+	// Stage is also order, using which stage durations will be serialized.
+	enum Stage { Read, Load, Parse, Blame, Fix, Serialize, Write, StageCount };
+	enum class Action { Unchanged, Updated, WouldUpdate, Skipped, Error };
+
+	QString path;  // Relative to repository root, so reports from different agents are comparable.
+	Action action = Action::Unchanged;
+	std::vector<header_fields::FieldType> changedFields;
+	std::vector<std::pair<QString, double>> authorShares;
+	std::size_t blameLineCount = 0;
+	std::array<qint64, StageCount> stageNsecs{};
+	qint64 totalNsecs = 0;
+};
@@ -0,0 +1,81 @@
+#include "ReportWriter.h"
+
+#include <QJsonDocument>
+
+#include "report_helpers.h"
+#include "src/logger/log.h"
+
+ReportWriter::ReportWriter(const QString &path)
+    : m_file(path)
+{
+	if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+		CN_ERR(logger::MsgCode::BadReport,
+		       "Error opening report " << path << ": " << m_file.errorString());
+		throw std::exception();
+	}
+
+	m_thread = std::thread(&ReportWriter::run, this);
+}
+
+ReportWriter::~ReportWriter()
+{
+	// Without summary line the report is treated as incomplete.
+	stop();
+}
+
+void ReportWriter::write(FileReport report)
+{
+	{
+		std::lock_guard l(m_mutex);
+		m_records.emplace_back(std::move(report));
+	}
+	m_hasRecords.notify_one();
+}
+
+void ReportWriter::close(int shardIndex, int shardCount, int exitCode)
+{
+	stop();
+
+	const auto summary = report_helpers::makeSummary(shardIndex, shardCount, exitCode);
+	m_file.write(QJsonDocument(summary).toJson(QJsonDocument::Compact));
+	m_file.write("\n");
+	m_file.close();
+}
+
+void ReportWriter::run()
+{
+	std::vector<FileReport> batch;
+
+	for (;;) {
+		{
+			std::unique_lock l(m_mutex);
+			m_hasRecords.wait(l, [this] { return m_isStopping || !m_records.empty(); });
+			if (m_records.empty()) {
+				return;  // Stopping and nothing left to write.
+			}
+			batch.swap(m_records);
+		}
+
+		for (const auto &report : batch) {
+			const auto json = QJsonDocument(report_helpers::toJson(report));
+			m_file.write(json.toJson(QJsonDocument::Compact));
+			m_file.write("\n");
+		}
+		m_file.flush();
+		batch.clear();
+	}
+}
+
+void ReportWriter::stop()
+{
+	if (!m_thread.joinable()) {
+		return;
+	}
+
+	{
+		std::lock_guard l(m_mutex);
+		m_isStopping = true;
+	}
+	m_hasRecords.notify_one();
+	m_thread.join();
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <QFile>
+#include <thread>
+
+#include "FileReport.h"
+
+// Writes one JSON line per processed file. Records are serialized and written by a dedicated
+// thread, so workers only pay for moving the record into the queue.
+struct ReportWriter
+{
+	explicit ReportWriter(const QString &path);
+	~ReportWriter();
+	ReportWriter(const ReportWriter &) = delete;
+
+	void write(FileReport report);
+
+	// Writes remaining records and summary line, which marks the report as complete.
+	void close(int shardIndex, int shardCount, int exitCode);
+
+private:
+	void run();
+	void stop();
+
+private:
+	QFile m_file;
+	std::mutex m_mutex;
+	std::condition_variable m_hasRecords;
+	std::vector<FileReport> m_records;
+	bool m_isStopping = false;
+	std::thread m_thread;
+};
@@ -0,0 +1,227 @@
+#include "report_helpers.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <set>
+
+#include "src/constants.h"
+#include "src/logger/log.h"
+
+namespace {
+
+using Msg = logger::MsgCode;
+
+// clang-format off
+constexpr std::array<const char *, FileReport::StageCount> cStageNames{
+    "read", "load", "parse", "blame", "fix", "serialize", "write"
+};
+// clang-format on
+
+const char *toActionName(FileReport::Action action)
+{
+	switch (action) {
+	case FileReport::Action::Unchanged: return "unchanged";
+	case FileReport::Action::Updated: return "updated";
+	case FileReport::Action::WouldUpdate: return "would-update";
+	case FileReport::Action::Skipped: return "skipped";
+	case FileReport::Action::Error: return "error";
+	}
+	assert(false);
+	return "";
+}
+
+double toMs(qint64 nsecs)
+{
+	return static_cast<double>(nsecs) / 1e6;
+}
+
+int exitCodeSeverity(int exitCode)
+{
+	switch (exitCode) {
+	case apperror::Success: return 0;
+	case apperror::FilesChanged: return 1;
+	default: return 2;
+	}
+}
+
+// Errors take precedence over 'FilesChanged', which takes precedence over 'Success'.
+int combineExitCodes(int left, int right)
+{
+	return exitCodeSeverity(right) > exitCodeSeverity(left) ? right : left;
+}
+
+std::vector<QJsonObject> readJsonLines(const QString &path)
+{
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly | QIODevice::ExistingOnly | QIODevice::Text)) {
+		CN_ERR(Msg::BadReport, "Error opening report " << path << ": " << file.errorString());
+		throw std::exception();
+	}
+
+	std::vector<QJsonObject> result;
+	while (!file.atEnd()) {
+		const auto line = file.readLine().trimmed();
+		if (line.isEmpty()) {
+			continue;
+		}
+
+		const auto doc = QJsonDocument::fromJson(line);
+		if (!doc.isObject()) {
+			CN_ERR(Msg::BadReport, "Unexpected line " << line << " in report " << path);
+			throw std::exception();
+		}
+		result.emplace_back(doc.object());
+	}
+
+	return result;
+}
+
+void writeJsonLines(const QString &path, const std::vector<QJsonObject> &records)
+{
+	QFile file(path);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+		CN_ERR(Msg::BadReport, "Error opening report " << path << ": " << file.errorString());
+		throw std::exception();
+	}
+
+	for (const auto &record : records) {
+		file.write(QJsonDocument(record).toJson(QJsonDocument::Compact));
+		file.write("\n");
+	}
+}
+
+}  // namespace
+
+namespace report_helpers {
+
+QJsonObject toJson(const FileReport &report)
+{
+	using namespace appconst::json::report;
+
+	QJsonArray changedFields;
+	for (const auto field : report.changedFields) {
+		changedFields.append(header_fields::toFieldName(field));
+	}
+
+	QJsonArray authors;
+	for (const auto &[name, share] : report.authorShares) {
+		authors.append(QJsonObject{{cName, name}, {cShare, share}});
+	}
+
+	QJsonObject stages;
+	for (int stage = 0; stage < FileReport::StageCount; stage++) {
+		stages.insert(QString(cStageNames[stage]), toMs(report.stageNsecs[stage]));
+	}
+
+	// clang-format off
+	return {
+	    {cPath, report.path}
+	    , {cAction, QLatin1String(toActionName(report.action))}
+	    , {cChangedFields, changedFields}
+	    , {cAuthors, authors}
+	    , {cBlameLines, static_cast<qint64>(report.blameLineCount)}
+	    , {cDurationMs, toMs(report.totalNsecs)}
+	    , {cStagesMs, stages}
+	};
+	// clang-format on
+}
+
+QJsonObject makeSummary(int shardIndex, int shardCount, int exitCode)
+{
+	using namespace appconst::json::report;
+	// clang-format off
+	return {
+	    {cShard, shardIndex + 1}
+	    , {cShardCount, shardCount}
+	    , {cExitCode, exitCode}
+	};
+	// clang-format on
+}
+
+shard_helpers::FileCosts readFileCosts(const QString &reportPath)
+{
+	using namespace appconst::json::report;
+
+	const QString skipped = toActionName(FileReport::Action::Skipped);
+	const QString error = toActionName(FileReport::Action::Error);
+
+	shard_helpers::FileCosts costs;
+	for (const auto &record : readJsonLines(reportPath)) {
+		if (!record.contains(cPath) || !record.contains(cDurationMs)) {
+			continue;
+		}
+
+		const auto action = record.value(cAction).toString();
+		if (action == skipped || action == error) {
+			continue;
+		}
+
+		costs[record.value(cPath).toString()] = record.value(cDurationMs).toDouble();
+	}
+	return costs;
+}
+
+int mergeReports(const QStringList &reportPaths, const QString &outputPath)
+{
+	using namespace appconst::json::report;
+
+	std::vector<QJsonObject> fileRecords;
+	std::set<int> mergedShards;
+	int shardCount = 0;
+	int exitCode = apperror::Success;
+
+	try {
+		for (const auto &path : reportPaths) {
+			bool hasSummary = false;
+
+			for (auto &record : readJsonLines(path)) {
+				if (!record.contains(cExitCode)) {
+					fileRecords.emplace_back(std::move(record));
+					continue;
+				}
+
+				hasSummary = true;
+				exitCode = combineExitCodes(exitCode, record.value(cExitCode).toInt());
+				// Shards are counted, so a report, that is passed twice, would hide a missing one.
+				const int shard = record.value(cShard).toInt();
+				if (!mergedShards.insert(shard).second) {
+					CN_ERR(Msg::BadReport, "Report " << path << " is of shard " << shard
+					                                 << ", that is already merged.");
+					return apperror::RunArgError;
+				}
+
+				const int count = record.value(cShardCount).toInt();
+				if (shardCount != 0 && shardCount != count) {
+					CN_ERR(Msg::BadReport, "Report " << path << " was made for " << count
+					                                 << " shards, expected " << shardCount);
+					return apperror::RunArgError;
+				}
+				shardCount = count;
+			}
+
+			if (!hasSummary) {
+				CN_ERR(Msg::BadReport,
+				       "Report " << path << " is incomplete, the shard has not finished.");
+				return apperror::InternalError;
+			}
+		}
+
+		if (static_cast<int>(mergedShards.size()) != shardCount) {
+			CN_ERR(Msg::BadReport,
+			       "Merged " << mergedShards.size() << " of " << shardCount << " shard reports.");
+			return apperror::InternalError;
+		}
+
+		if (!outputPath.isEmpty()) {
+			fileRecords.emplace_back(makeSummary(0, 1, exitCode));
+			writeJsonLines(outputPath, fileRecords);
+		}
+	} catch (const std::exception &) {
+		return apperror::InternalError;
+	}
+
+	return exitCode;
+}
+
+}  // namespace report_helpers
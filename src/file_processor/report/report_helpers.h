@@ -0,0 +1,20 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QStringList>
+
+#include "FileReport.h"
+#include "src/file_processor/shard/shard_helpers.h"
+
+namespace report_helpers {
+
+[[nodiscard]] QJsonObject toJson(const FileReport &report);
+[[nodiscard]] QJsonObject makeSummary(int shardIndex, int shardCount, int exitCode);
+
+// Returns durations of files which were fully processed by the run that wrote the report.
+[[nodiscard]] shard_helpers::FileCosts readFileCosts(const QString &reportPath);
+
+// Merges reports of all shards into 'outputPath' (if not empty) and returns combined exit code.
+[[nodiscard]] int mergeReports(const QStringList &reportPaths, const QString &outputPath);
+
+}  // namespace report_helpers
@@ -0,0 +1,99 @@
+#include "shard_helpers.h"
+
+#include <numeric>
+#include <queue>
+
+namespace {
+
+std::vector<std::size_t> selectShardByHash(const std::vector<QString> &relativePaths,
+                                           int shardIndex, int shardCount)
+{
+	const auto count = static_cast<quint64>(shardCount);
+	const auto index = static_cast<quint64>(shardIndex);
+
+	std::vector<std::size_t> result;
+	for (std::size_t i = 0; i < relativePaths.size(); i++) {
+		if (shard_helpers::stablePathHash(relativePaths[i]) % count == index) {
+			result.emplace_back(i);
+		}
+	}
+	return result;
+}
+
+std::vector<std::size_t> selectShardByCost(const std::vector<QString> &relativePaths,
+                                           int shardIndex, int shardCount,
+                                           const shard_helpers::FileCosts &costs)
+{
+	double knownCostSum = 0;
+	for (const auto &[_, cost] : costs) {
+		knownCostSum += cost;
+	}
+	// Files that were not seen by the previous run are considered as an average file.
+	const double defaultCost = knownCostSum / static_cast<double>(costs.size());
+
+	std::vector<std::pair<double, std::size_t>> files;
+	files.reserve(relativePaths.size());
+	for (std::size_t i = 0; i < relativePaths.size(); i++) {
+		const auto itr = costs.find(relativePaths[i]);
+		files.emplace_back(itr == costs.end() ? defaultCost : itr->second, i);
+	}
+
+	// Most expensive first, path makes the order total, so every shard gets the same assignment.
+	std::sort(files.begin(), files.end(), [&relativePaths](const auto &l, const auto &r) {
+		return l.first != r.first ? l.first > r.first
+		                          : relativePaths[l.second] < relativePaths[r.second];
+	});
+
+	using ShardLoad = std::pair<double, int>;
+	std::priority_queue<ShardLoad, std::vector<ShardLoad>, std::greater<>> loads;
+	for (int i = 0; i < shardCount; i++) {
+		loads.emplace(0., i);
+	}
+
+	std::vector<std::size_t> result;
+	for (const auto &[cost, pathIndex] : files) {
+		const auto [load, index] = loads.top();
+		loads.pop();
+		loads.emplace(load + cost, index);
+
+		if (index == shardIndex) {
+			result.emplace_back(pathIndex);
+		}
+	}
+
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+}  // namespace
+
+namespace shard_helpers {
+
+quint64 stablePathHash(const QString &relativePath)
+{
+	// FNV-1a, it does not depend on platform, Qt version or process seed like qHash does.
+	constexpr quint64 offsetBasis = 14695981039346656037ull;
+	constexpr quint64 prime = 1099511628211ull;
+
+	quint64 hash = offsetBasis;
+	for (const char ch : relativePath.toUtf8()) {
+		hash ^= static_cast<unsigned char>(ch);
+		hash *= prime;
+	}
+	return hash;
+}
+
+std::vector<std::size_t> selectShard(const std::vector<QString> &relativePaths, int shardIndex,
+                                     int shardCount, const FileCosts &costs)
+{
+	if (shardCount <= 1) {
+		std::vector<std::size_t> all(relativePaths.size());
+		std::iota(all.begin(), all.end(), 0);
+		return all;
+	}
+
+	return costs.empty() ? selectShardByHash(relativePaths, shardIndex, shardCount)
+	                     : selectShardByCost(relativePaths, shardIndex, shardCount, costs);
+}
+
+}  // namespace shard_helpers
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <QString>
+#include <unordered_map>
+#include <vector>
+
+namespace shard_helpers {
+
+using FileCosts = std::unordered_map<QString, double>;
+
+[[nodiscard]] quint64 stablePathHash(const QString &relativePath);
+
+// Returns indexes of 'relativePaths' that belong to 'shardIndex' (0-based) out of 'shardCount'.
+// If 'costs' are empty, files are distributed by stable path hash, otherwise the most expensive
+// files are assigned first to the least loaded shard. Result depends only on the input set.
+[[nodiscard]] std::vector<std::size_t> selectShard(const std::vector<QString> &relativePaths,
+                                                   int shardIndex, int shardCount,
+                                                   const FileCosts &costs);
+
+}  // namespace shard_helpers
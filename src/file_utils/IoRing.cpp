@@ -0,0 +1,194 @@
+#include "IoRing.h"
+
+#ifdef CN_HAS_IO_URING
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "src/logger/log.h"
+
+namespace {
+
+int setup(unsigned entries, io_uring_params &params)
+{
+	return static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+}
+
+int enter(int fd, unsigned toSubmit, unsigned minComplete)
+{
+	return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete,
+	                                  IORING_ENTER_GETEVENTS, nullptr, 0));
+}
+
+int registerProbe(int fd, io_uring_probe &probe, unsigned opCount)
+{
+	return static_cast<int>(
+	    ::syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, &probe, opCount));
+}
+
+// Ring indexes are shared with the kernel.
+unsigned loadAcquire(unsigned *value)
+{
+	return std::atomic_ref(*value).load(std::memory_order_acquire);
+}
+
+void storeRelease(unsigned *value, unsigned newValue)
+{
+	std::atomic_ref(*value).store(newValue, std::memory_order_release);
+}
+
+template<typename T>
+T *at(void *ring, unsigned offset)
+{
+	return reinterpret_cast<T *>(static_cast<char *>(ring) + offset);
+}
+
+}  // namespace
+
+IoRing::IoRing(unsigned entries)
+{
+	io_uring_params params{};
+	m_fd = setup(entries, params);
+	if (m_fd < 0) {
+		CN_DEBUG("io_uring is not available:" << strerror(errno));
+		return;
+	}
+	m_entries = params.sq_entries;
+
+	m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	const bool isSingleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+	if (isSingleMmap) {
+		m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+	}
+
+	const auto map = [this](std::size_t size, off_t offset) -> void * {
+		void *ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd,
+		                   offset);
+		return ptr == MAP_FAILED ? nullptr : ptr;
+	};
+
+	m_sqRing = map(m_sqRingSize, IORING_OFF_SQ_RING);
+	m_cqRing = isSingleMmap ? m_sqRing : map(m_cqRingSize, IORING_OFF_CQ_RING);
+	m_sqes = static_cast<io_uring_sqe *>(
+	    map(params.sq_entries * sizeof(io_uring_sqe), IORING_OFF_SQES));
+	if (!m_sqRing || !m_cqRing || !m_sqes) {
+		CN_DEBUG("io_uring rings are not mapped:" << strerror(errno));
+		unmap();
+		return;
+	}
+
+	m_sqHead = at<unsigned>(m_sqRing, params.sq_off.head);
+	m_sqTail = at<unsigned>(m_sqRing, params.sq_off.tail);
+	m_sqMask = at<unsigned>(m_sqRing, params.sq_off.ring_mask);
+	m_sqArray = at<unsigned>(m_sqRing, params.sq_off.array);
+	m_cqHead = at<unsigned>(m_cqRing, params.cq_off.head);
+	m_cqTail = at<unsigned>(m_cqRing, params.cq_off.tail);
+	m_cqMask = at<unsigned>(m_cqRing, params.cq_off.ring_mask);
+	m_cqes = at<io_uring_cqe>(m_cqRing, params.cq_off.cqes);
+
+	if (!probeOperations()) {
+		unmap();
+	}
+}
+
+IoRing::~IoRing()
+{
+	unmap();
+}
+
+bool IoRing::run(const std::vector<io_uring_sqe> &operations, std::vector<int> &results)
+{
+	results.assign(operations.size(), -ECANCELED);
+	if (!isValid()) {
+		return false;
+	}
+
+	// At most 'm_entries' operations are in flight, so completions never overflow the queue, which
+	// is twice as long.
+	std::size_t submitted = 0;
+	std::size_t completed = 0;
+	while (completed < operations.size()) {
+		auto tail = *m_sqTail;
+		while (submitted < operations.size() && submitted - completed < m_entries) {
+			const auto index = tail & *m_sqMask;
+			m_sqes[index] = operations[submitted];
+			m_sqes[index].user_data = submitted;
+			m_sqArray[index] = index;
+			tail++;
+			submitted++;
+		}
+		storeRelease(m_sqTail, tail);
+
+		// Entries, which were not consumed by the previous call, are submitted again.
+		while (enter(m_fd, tail - loadAcquire(m_sqHead), 1) < 0) {
+			if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+				CN_WARN(logger::MsgCode::FileReadWriteError,
+				        "io_uring failed, files are read one by one: " << strerror(errno));
+				unmap();
+				return false;
+			}
+		}
+
+		auto head = *m_cqHead;
+		for (const auto cqTail = loadAcquire(m_cqTail); head != cqTail; head++) {
+			const auto &cqe = m_cqes[head & *m_cqMask];
+			results[cqe.user_data] = cqe.res;
+			completed++;
+		}
+		storeRelease(m_cqHead, head);
+	}
+
+	return true;
+}
+
+bool IoRing::probeOperations()
+{
+	constexpr unsigned cOpCount = 256;
+	const auto probeSize = sizeof(io_uring_probe) + cOpCount * sizeof(io_uring_probe_op);
+	const std::unique_ptr<char[]> buffer(new char[probeSize]());
+	auto &probe = *reinterpret_cast<io_uring_probe *>(buffer.get());
+
+	// Probing itself is supported since Linux 5.6, as well as openat and read.
+	if (registerProbe(m_fd, probe, cOpCount) < 0) {
+		CN_DEBUG("io_uring operations are not probed:" << strerror(errno));
+		return false;
+	}
+
+	const auto isSupported = [&probe](unsigned op) {
+		return op <= probe.last_op && (probe.ops[op].flags & IO_URING_OP_SUPPORTED);
+	};
+	if (!isSupported(IORING_OP_OPENAT) || !isSupported(IORING_OP_READ)) {
+		CN_DEBUG("io_uring does not support openat or read");
+		return false;
+	}
+	return true;
+}
+
+void IoRing::unmap()
+{
+	if (m_sqes) {
+		::munmap(m_sqes, m_entries * sizeof(io_uring_sqe));
+	}
+	if (m_cqRing && m_cqRing != m_sqRing) {
+		::munmap(m_cqRing, m_cqRingSize);
+	}
+	if (m_sqRing) {
+		::munmap(m_sqRing, m_sqRingSize);
+	}
+	if (m_fd >= 0) {
+		::close(m_fd);
+	}
+
+	m_sqes = nullptr;
+	m_sqRing = m_cqRing = nullptr;
+	m_fd = -1;
+}
+
+#endif
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QtGlobal>
+#include <vector>
+
+#if defined(CN_USE_IO_URING) && defined(Q_OS_LINUX) && __has_include(<linux/io_uring.h>)
+#define CN_HAS_IO_URING
+#include <linux/io_uring.h>
+#endif
+
+#ifdef CN_HAS_IO_URING
+
+// Minimal io_uring over raw system calls, so liburing is not required. It is invalid, if the kernel
+// does not support io_uring or the operations, that are used by file_utils (Linux 5.6), or it is
+// forbidden, e.g. by seccomp in containers.
+struct IoRing
+{
+	explicit IoRing(unsigned entries);
+	~IoRing();
+	IoRing(const IoRing &) = delete;
+	IoRing &operator=(const IoRing &) = delete;
+
+	[[nodiscard]] bool isValid() const { return m_fd >= 0; }
+
+	// Submits all operations, keeping at most the ring size of them in flight, and waits for them.
+	// 'results' get result of every operation (negative errno on failure). Returns false, if the
+	// ring itself failed, after which it is invalid.
+	[[nodiscard]] bool run(const std::vector<io_uring_sqe> &operations, std::vector<int> &results);
+
+private:
+	bool probeOperations();
+	void unmap();
+
+private:
+	int m_fd = -1;
+	unsigned m_entries = 0;
+
+	void *m_sqRing = nullptr;
+	void *m_cqRing = nullptr;
+	std::size_t m_sqRingSize = 0;
+	std::size_t m_cqRingSize = 0;
+	io_uring_sqe *m_sqes = nullptr;
+
+	unsigned *m_sqHead = nullptr;
+	unsigned *m_sqTail = nullptr;
+	unsigned *m_sqMask = nullptr;
+	unsigned *m_sqArray = nullptr;
+	unsigned *m_cqHead = nullptr;
+	unsigned *m_cqTail = nullptr;
+	unsigned *m_cqMask = nullptr;
+	io_uring_cqe *m_cqes = nullptr;
+};
+
+#endif
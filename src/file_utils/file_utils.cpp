@@ -1,15 +1,203 @@
 #include "file_utils.h"
 
 #include <QFile>
+#include <QSaveFile>
 
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "IoRing.h"
 #include "src/logger/log.h"
 
+namespace {
+
+using Msg = logger::MsgCode;
+
+constexpr qint64 cCopyChunkSize = 1024 * 1024;
+#ifdef CN_HAS_IO_URING
+constexpr unsigned cIoRingEntries = 64;
+#endif
+
+// Copies 'source' starting from 'offset' to the current position of 'target' in kernel space.
+// Returns false if nothing was copied, because the file systems do not support it.
+bool copyFileRange(QFile &source, qint64 offset, QFileDevice &target)
+{
+#ifdef Q_OS_LINUX
+	loff_t sourceOffset = offset;
+	qint64 remaining = source.size() - offset;
+	while (remaining > 0) {
+		const auto copied = ::copy_file_range(source.handle(), &sourceOffset, target.handle(),
+		                                      nullptr, static_cast<std::size_t>(remaining), 0);
+		if (copied < 0) {
+			const bool isUnsupported =
+			    errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP;
+			if (isUnsupported && sourceOffset == offset) {
+				return false;
+			}
+			CN_ERR(Msg::FileReadWriteError,
+			       "Error copying file " << source.fileName() << ": " << strerror(errno));
+			throw std::exception();
+		}
+		if (copied == 0) {
+			break;
+		}
+		remaining -= copied;
+	}
+	return true;
+#else
+	Q_UNUSED(source)
+	Q_UNUSED(offset)
+	Q_UNUSED(target)
+	return false;
+#endif
+}
+
+void copyChunks(QFile &source, qint64 offset, QFileDevice &target)
+{
+	if (!source.seek(offset)) {
+		CN_ERR(Msg::FileReadWriteError,
+		       "Error reading file " << source.fileName() << ": " << source.errorString());
+		throw std::exception();
+	}
+
+	while (!source.atEnd()) {
+		const auto chunk = source.read(cCopyChunkSize);
+		if (chunk.isEmpty() || target.write(chunk) != chunk.size()) {
+			CN_ERR(Msg::FileReadWriteError,
+			       "Error copying file " << source.fileName() << ": " << target.errorString());
+			throw std::exception();
+		}
+	}
+}
+
+#ifdef CN_HAS_IO_URING
+
+// File, that is opened and is being read by the ring.
+struct RingRead
+{
+	std::size_t index;
+	int fd;
+	QByteArray buffer;
+	qint64 readSize = 0;
+};
+
+io_uring_sqe openOperation(const QByteArray &path)
+{
+	io_uring_sqe sqe{};
+	sqe.opcode = IORING_OP_OPENAT;
+	sqe.fd = AT_FDCWD;
+	sqe.addr = reinterpret_cast<__u64>(path.constData());
+	sqe.open_flags = O_RDONLY | O_CLOEXEC;
+	return sqe;
+}
+
+io_uring_sqe readOperation(RingRead &read)
+{
+	io_uring_sqe sqe{};
+	sqe.opcode = IORING_OP_READ;
+	sqe.fd = read.fd;
+	sqe.addr = reinterpret_cast<__u64>(read.buffer.data() + read.readSize);
+	sqe.len = static_cast<__u32>(read.buffer.size() - read.readSize);
+	sqe.off = static_cast<__u64>(read.readSize);
+	return sqe;
+}
+
+// Opens all files and allocates buffers for the parts, that have to be read.
+bool openFiles(IoRing &ring, std::vector<file_utils::FileRead> &reads,
+               std::vector<RingRead> &opened)
+{
+	std::vector<QByteArray> paths;
+	std::vector<io_uring_sqe> operations;
+	paths.reserve(reads.size());
+	operations.reserve(reads.size());
+	for (const auto &read : reads) {
+		operations.emplace_back(openOperation(paths.emplace_back(QFile::encodeName(read.path))));
+	}
+
+	std::vector<int> fds;
+	const bool isRun = ring.run(operations, fds);
+	for (std::size_t i = 0; i < fds.size(); i++) {
+		if (fds[i] < 0) {
+			continue;
+		}
+
+		struct stat info{};
+		if (!isRun || ::fstat(fds[i], &info) != 0 || info.st_size == 0) {
+			::close(fds[i]);
+			continue;
+		}
+
+		auto &read = reads[i];
+		read.isHead = read.headSize > 0 && info.st_size >= read.headFileSize;
+		const auto size = read.isHead ? std::min<qint64>(info.st_size, read.headSize)
+		                              : static_cast<qint64>(info.st_size);
+		opened.push_back({i, fds[i], QByteArray(static_cast<int>(size), Qt::Uninitialized)});
+	}
+	return isRun;
+}
+
+// Reads until buffers are filled, because reads may be short, e.g. on network file systems.
+bool readOpenedFiles(IoRing &ring, std::vector<file_utils::FileRead> &reads,
+                     std::vector<RingRead> &opened)
+{
+	std::vector<RingRead *> pending;
+	for (auto &read : opened) {
+		pending.emplace_back(&read);
+	}
+
+	std::vector<io_uring_sqe> operations;
+	std::vector<int> results;
+	while (!pending.empty()) {
+		operations.clear();
+		for (auto *read : pending) {
+			operations.emplace_back(readOperation(*read));
+		}
+		if (!ring.run(operations, results)) {
+			return false;
+		}
+
+		std::vector<RingRead *> unfinished;
+		for (std::size_t i = 0; i < pending.size(); i++) {
+			auto &read = *pending[i];
+			if (results[i] < 0) {
+				continue;
+			}
+
+			read.readSize += results[i];
+			if (results[i] > 0 && read.readSize < read.buffer.size()) {
+				unfinished.emplace_back(&read);
+				continue;
+			}
+
+			// File may be truncated after it was opened.
+			read.buffer.truncate(static_cast<int>(read.readSize));
+			auto &file = reads[read.index];
+			if (!file.isHead) {
+				// Like QIODevice::Text, that removes carriage returns.
+				read.buffer.replace("\r", "");
+			}
+			if (!read.buffer.isEmpty()) {
+				file.content = std::move(read.buffer);
+			}
+		}
+		pending = std::move(unfinished);
+	}
+	return true;
+}
+
+#endif
+
+}  // namespace
+
 namespace file_utils {
 
 QByteArray readFile(const QString &path)
 {
-	using Msg = logger::MsgCode;
-
 	QFile file(path);
 	if (!file.open(QIODevice::ReadOnly | QIODevice::ExistingOnly | QIODevice::Text)) {
 		CN_ERR(Msg::FileReadWriteError,
@@ -28,8 +216,6 @@ QByteArray readFile(const QString &path)
 
 void writeFile(const QString &path, const QByteArray &content)
 {
-	using Msg = logger::MsgCode;
-
 	QFile file(path);
 	if (!file.open(QIODevice::WriteOnly | QIODevice::ExistingOnly | QIODevice::Text)) {
 		CN_ERR(Msg::FileReadWriteError,
@@ -45,4 +231,105 @@ void writeFile(const QString &path, const QByteArray &content)
 	}
 }
 
-}  // namespace file_utils
\ No newline at end of file
+QByteArray readFileHead(const QString &path, qint64 maxSize)
+{
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly | QIODevice::ExistingOnly)) {
+		CN_ERR(Msg::FileReadWriteError,
+		       "Error opening file " << path << ": " << file.errorString());
+		throw std::exception();
+	}
+
+	QByteArray content = file.read(maxSize);
+	if (content.isEmpty()) {
+		CN_ERR(Msg::FileReadWriteError, "Error reading file or file is empty " << path);
+		throw std::exception();
+	}
+
+	return content;
+}
+
+QByteArray readFileTail(const QString &path, qint64 offset)
+{
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly | QIODevice::ExistingOnly) || !file.seek(offset)) {
+		CN_ERR(Msg::FileReadWriteError,
+		       "Error reading file " << path << ": " << file.errorString());
+		throw std::exception();
+	}
+
+	return file.readAll();
+}
+
+bool hasCrLfLineEnds(const QString &path)
+{
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly | QIODevice::ExistingOnly)) {
+		return false;
+	}
+
+	return file.readLine().endsWith("\r\n");
+}
+
+void replaceFileHead(const QString &path, qint64 headSize, const QByteArray &newHead)
+{
+	QFile source(path);
+	if (!source.open(QIODevice::ReadOnly | QIODevice::ExistingOnly)) {
+		CN_ERR(Msg::FileReadWriteError,
+		       "Error opening file " << path << ": " << source.errorString());
+		throw std::exception();
+	}
+
+	// QSaveFile writes to a temporary file in the same directory and renames it on commit.
+	QSaveFile target(path);
+	if (!target.open(QIODevice::WriteOnly)) {
+		CN_ERR(Msg::FileReadWriteError,
+		       "Error opening file " << path << ": " << target.errorString());
+		throw std::exception();
+	}
+
+	if (target.write(newHead) != newHead.size() || !target.flush()) {
+		CN_ERR(Msg::FileReadWriteError,
+		       "Error writing file " << path << ": " << target.errorString());
+		throw std::exception();
+	}
+
+	if (!copyFileRange(source, headSize, target)) {
+		copyChunks(source, headSize, target);
+	}
+
+	if (!target.commit()) {
+		CN_ERR(Msg::FileReadWriteError,
+		       "Error writing file " << path << ": " << target.errorString());
+		throw std::exception();
+	}
+}
+
+bool readFiles(std::vector<FileRead> &reads)
+{
+#ifdef CN_HAS_IO_URING
+	// Files are read by the thread, that enumerates them, so every thread has its own ring.
+	thread_local IoRing ring(cIoRingEntries);
+	if (!ring.isValid()) {
+		return false;
+	}
+
+	std::vector<RingRead> opened;
+	const bool isRead = openFiles(ring, reads, opened) && readOpenedFiles(ring, reads, opened);
+	for (const auto &read : opened) {
+		::close(read.fd);
+	}
+
+	if (!isRead) {
+		for (auto &read : reads) {
+			read.content.reset();
+		}
+	}
+	return isRead;
+#else
+	Q_UNUSED(reads)
+	return false;
+#endif
+}
+
+}  // namespace file_utils
@@ -1,10 +1,41 @@
 #pragma once
 
 #include <QFile>
+#include <optional>
+#include <vector>
 
 namespace file_utils {
 
 QByteArray readFile(const QString &path);
 void writeFile(const QString &path, const QByteArray &content);
 
-}
\ No newline at end of file
+// Reads at most 'maxSize' bytes from the beginning of the file.
+QByteArray readFileHead(const QString &path, qint64 maxSize);
+// Reads the rest of the file after first 'offset' bytes.
+QByteArray readFileTail(const QString &path, qint64 offset);
+// Returns true, if the first line of the file ends with "\r\n", that readFile() reads as '\n'.
+bool hasCrLfLineEnds(const QString &path);
+// Replaces first 'headSize' bytes of the file with 'newHead'. The rest of the file is copied to a
+// temporary file by the kernel where possible, and the temporary file replaces the original one.
+void replaceFileHead(const QString &path, qint64 headSize, const QByteArray &newHead);
+
+// File, that is read by readFiles(). Files of at least 'headFileSize' bytes are read up to
+// 'headSize' bytes like with readFileHead(), if 'headSize' is set, and others are read whole like
+// with readFile().
+struct FileRead
+{
+	QString path;
+	qint64 headFileSize = 0;
+	qint64 headSize = 0;
+
+	// Empty, if the file is not read or is empty, so it is read again with the functions above,
+	// which report the error.
+	std::optional<QByteArray> content;
+	bool isHead = false;
+};
+
+// Opens and reads all files at once with io_uring, so reads from slow file systems overlap. Returns
+// false, if io_uring is not available, and the files have to be read one by one.
+bool readFiles(std::vector<FileRead> &reads);
+
+}  // namespace file_utils
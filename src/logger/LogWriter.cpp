@@ -0,0 +1,184 @@
+#include "LogWriter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <QDateTime>
+
+#include "log.h"
+
+namespace {
+
+std::atomic<std::uint64_t> gLastWriterId = 0;
+
+QByteArray formatRecord(qint64 msecsSinceEpoch, const QString &message)
+{
+	// Matches "%{time} %{message}" pattern set by logger::environment::setPattern.
+	const auto time = QDateTime::fromMSecsSinceEpoch(msecsSinceEpoch).toString(Qt::ISODate);
+	return (time + ' ' + message + '\n').toLocal8Bit();
+}
+
+void writeToStderr(const QByteArray &batch)
+{
+	std::fwrite(batch.constData(), 1, static_cast<std::size_t>(batch.size()), stderr);
+	std::fflush(stderr);
+}
+
+}  // namespace
+
+bool LogWriter::Ring::tryPush(Record &record)
+{
+	const auto currentHead = head.load(std::memory_order_relaxed);
+	if (currentHead - tail.load(std::memory_order_acquire) == cCapacity) {
+		return false;
+	}
+
+	records[currentHead & (cCapacity - 1)] = std::move(record);
+	head.store(currentHead + 1, std::memory_order_release);
+	return true;
+}
+
+bool LogWriter::Ring::pop(Record &record)
+{
+	const auto currentTail = tail.load(std::memory_order_relaxed);
+	if (currentTail == head.load(std::memory_order_acquire)) {
+		return false;
+	}
+
+	record = std::move(records[currentTail & (cCapacity - 1)]);
+	tail.store(currentTail + 1, std::memory_order_release);
+	return true;
+}
+
+LogWriter::LogWriter(OverflowPolicy policy, Sink sink)
+    : m_policy(policy)
+    , m_sink(sink ? std::move(sink) : writeToStderr)
+    , m_id(++gLastWriterId)
+{
+	m_thread = std::thread(&LogWriter::run, this);
+}
+
+LogWriter::~LogWriter()
+{
+	m_isStopping.store(true);
+	m_sequence.fetch_add(1, std::memory_order_release);
+	m_sequence.notify_one();
+	m_thread.join();
+}
+
+void LogWriter::write(QString message)
+{
+	Record record{QDateTime::currentMSecsSinceEpoch(), std::move(message)};
+	auto &ring = threadRing();
+
+	for (;;) {
+		// Is read before the push, so a drain, that happens after a failed push, is not missed.
+		const auto drainCount = m_drainCount.load(std::memory_order_acquire);
+		if (ring.tryPush(record)) {
+			break;
+		}
+
+		if (m_policy == OverflowPolicy::Drop) {
+			m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		m_sequence.fetch_add(1, std::memory_order_release);
+		m_sequence.notify_one();
+		m_drainCount.wait(drainCount, std::memory_order_acquire);
+	}
+
+	m_sequence.fetch_add(1, std::memory_order_release);
+	m_sequence.notify_one();
+}
+
+LogWriter::Ring &LogWriter::threadRing()
+{
+	// Releases the ring for reuse, when the thread finishes.
+	struct RingOwner
+	{
+		~RingOwner()
+		{
+			if (ring) {
+				ring->isOwned.store(false, std::memory_order_release);
+			}
+		}
+
+		std::uint64_t writerId = 0;
+		std::shared_ptr<Ring> ring;
+	};
+	thread_local RingOwner owner;
+
+	if (owner.writerId == m_id) {
+		return *owner.ring;
+	}
+
+	std::lock_guard l(m_ringsMutex);
+	const auto freeRing = std::find_if(m_rings.cbegin(), m_rings.cend(), [](const auto &ring) {
+		return !ring->isOwned.load(std::memory_order_acquire);
+	});
+
+	if (freeRing != m_rings.cend()) {
+		owner.ring = *freeRing;
+		owner.ring->isOwned.store(true, std::memory_order_relaxed);
+	} else {
+		owner.ring = m_rings.emplace_back(std::make_shared<Ring>());
+	}
+	owner.writerId = m_id;
+	return *owner.ring;
+}
+
+void LogWriter::run()
+{
+	QByteArray batch;
+
+	for (;;) {
+		const auto sequence = m_sequence.load(std::memory_order_acquire);
+		const bool isStopping = m_isStopping.load();
+
+		const auto count = drain(batch);
+		if (count > 0) {
+			// Wakes producers, that wait for free space in their rings.
+			m_drainCount.fetch_add(1, std::memory_order_release);
+			m_drainCount.notify_all();
+
+			m_sink(batch);
+			batch.clear();
+			continue;
+		}
+
+		if (isStopping) {
+			return;
+		}
+
+		m_sequence.wait(sequence, std::memory_order_acquire);
+	}
+}
+
+std::size_t LogWriter::drain(QByteArray &batch)
+{
+	std::vector<std::shared_ptr<Ring>> rings;
+	{
+		std::lock_guard l(m_ringsMutex);
+		rings = m_rings;
+	}
+
+	std::size_t count = 0;
+	Record record;
+	for (const auto &ring : rings) {
+		while (ring->pop(record)) {
+			batch += formatRecord(record.msecsSinceEpoch, record.message);
+			++count;
+		}
+	}
+
+	const auto droppedCount = m_droppedCount.exchange(0, std::memory_order_relaxed);
+	if (droppedCount > 0) {
+		const auto message = QString("[W%1] Dropped %2 log messages, logging could not keep up.")
+		                         .arg(logger::MsgCode::LogMessagesDropped)
+		                         .arg(droppedCount);
+		batch += formatRecord(QDateTime::currentMSecsSinceEpoch(), message);
+		++count;
+	}
+
+	return count;
+}
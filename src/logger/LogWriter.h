@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <QString>
+#include <thread>
+#include <vector>
+
+// Collects log messages in per-thread lock-free ring buffers. Messages are formatted and written
+// to stderr in batches by a dedicated thread, so workers neither format nor lock the output.
+// Messages of one thread keep their order, messages of different threads may interleave.
+struct LogWriter
+{
+	enum class OverflowPolicy { Block, Drop };
+	// Gets formatted batches of messages on the writer thread.
+	using Sink = std::function<void(const QByteArray &batch)>;
+
+	// Batches are written to stderr, unless 'sink' is set.
+	explicit LogWriter(OverflowPolicy policy, Sink sink = {});
+	~LogWriter();
+	LogWriter(const LogWriter &) = delete;
+
+	void write(QString message);
+
+private:
+	struct Record
+	{
+		qint64 msecsSinceEpoch = 0;
+		QString message;
+	};
+
+	// Single producer (owning thread), single consumer (writer thread).
+	struct Ring
+	{
+		static constexpr std::size_t cCapacity = 1024;  // Must be a power of two.
+
+		bool tryPush(Record &record);
+		bool pop(Record &record);
+
+		std::array<Record, cCapacity> records;
+		alignas(64) std::atomic<std::size_t> head = 0;  // Next slot to write.
+		alignas(64) std::atomic<std::size_t> tail = 0;  // Next slot to read.
+		std::atomic_bool isOwned = true;
+	};
+
+	Ring &threadRing();
+	void run();
+	std::size_t drain(QByteArray &batch);
+
+private:
+	const OverflowPolicy m_policy;
+	const Sink m_sink;
+	const std::uint64_t m_id;
+	std::mutex m_ringsMutex;  // Guards the list only, rings are accessed without locking.
+	std::vector<std::shared_ptr<Ring>> m_rings;
+	std::atomic<std::uint64_t> m_sequence = 0;  // Is increased by producers to wake the writer.
+	std::atomic<std::uint64_t> m_drainCount = 0;  // Is increased by the writer to wake producers.
+	std::atomic<std::uint64_t> m_droppedCount = 0;
+	std::atomic_bool m_isStopping = false;
+	std::thread m_thread;
+};
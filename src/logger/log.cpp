@@ -1,18 +1,30 @@
 #include "log.h"
 
-namespace {
+#include <atomic>
+
+#include "LogWriter.h"
 
-bool gDebugLoggingOn = false;
+namespace {
 
 const QtMessageHandler QT_DEFAULT_MESSAGE_HANDLER = qInstallMessageHandler(nullptr);
 
+// Is owned here and deleted by logger::shutdown(), not during static destruction.
+std::atomic<LogWriter *> gLogWriter = nullptr;
+
 void messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
 {
-	if (type == QtDebugMsg && !gDebugLoggingOn) {
+	// Qt's own debug messages are not gated by the CN_* macros.
+	if (type == QtDebugMsg && !logger::isEnabled(logger::Level::Debug)) {
 		return;
 	}
 
-	(*QT_DEFAULT_MESSAGE_HANDLER)(type, context, msg);
+	auto *writer = gLogWriter.load(std::memory_order_acquire);
+	if (writer == nullptr || type == QtFatalMsg) {
+		(*QT_DEFAULT_MESSAGE_HANDLER)(type, context, msg);
+		return;
+	}
+
+	writer->write(msg);
 }
 
 }  // namespace
@@ -29,8 +41,24 @@ void logger::environment::setPattern()
 	        " %{message}");
 }
 
-void logger::init(bool verbose)
+void logger::setVerbose(bool verbose)
 {
-	gDebugLoggingOn = verbose;
+	impl::gMinLevel.store(verbose ? Level::Debug : Level::Info, std::memory_order_relaxed);
+}
+
+void logger::init(bool verbose, bool dropOnOverflow)
+{
+	setVerbose(verbose);
+
+	using Policy = LogWriter::OverflowPolicy;
+	delete gLogWriter.exchange(new LogWriter(dropOnOverflow ? Policy::Drop : Policy::Block),
+	                           std::memory_order_acq_rel);
+
 	qInstallMessageHandler(messageHandler);
 }
+
+void logger::shutdown()
+{
+	// Destructor writes messages, that are already in the rings.
+	delete gLogWriter.exchange(nullptr, std::memory_order_acq_rel);
+}
@@ -5,13 +5,43 @@
 
 #include "src/constants.h"
 
-#define CN_DEBUG(msg) qDebug() << "[D0]" << msg
-#define CN_INF(code, msg) qInfo().nospace() << "[I" << (code) << "]" << ' ' << msg
-#define CN_WARN(code, msg) qWarning().nospace() << "[W" << (code) << "]" << ' ' << msg
-#define CN_ERR(code, msg) qCritical().nospace() << "[E" << (code) << "]" << ' ' << msg
+#include <atomic>
+
+// Messages below this level are compiled out (0 - debug, 1 - info, 2 - warning, 3 - error).
+#ifndef CN_MIN_LOG_LEVEL
+#define CN_MIN_LOG_LEVEL 0
+#endif
+
+// Arguments of disabled messages are not evaluated. The 'else' branch keeps the macros usable as
+// a single statement, e.g. in 'if' without braces.
+#define CN_LOG_IF_ENABLED(level) if (!logger::isEnabled(level)) {} else
+
+#define CN_DEBUG(msg) CN_LOG_IF_ENABLED(logger::Level::Debug) qDebug() << "[D0]" << msg
+#define CN_INF(code, msg)                                                                          \
+	CN_LOG_IF_ENABLED(logger::Level::Info) qInfo().nospace() << "[I" << (code) << "]" << ' ' << msg
+#define CN_WARN(code, msg)                                                                         \
+	CN_LOG_IF_ENABLED(logger::Level::Warning)                                                      \
+	qWarning().nospace() << "[W" << (code) << "]" << ' ' << msg
+#define CN_ERR(code, msg)                                                                          \
+	CN_LOG_IF_ENABLED(logger::Level::Error)                                                        \
+	qCritical().nospace() << "[E" << (code) << "]" << ' ' << msg
 
 namespace logger {
 
+enum class Level { Debug, Info, Warning, Error };
+
+namespace impl {
+
+inline std::atomic<Level> gMinLevel = Level::Info;
+
+}  // namespace impl
+
+inline bool isEnabled(Level level)
+{
+	constexpr auto compiledMinLevel = static_cast<Level>(CN_MIN_LOG_LEVEL);
+	return level >= compiledMinLevel && level >= impl::gMinLevel.load(std::memory_order_relaxed);
+}
+
 // clang-format off
 enum MsgCode {
 	  Debug                      = 0
@@ -25,6 +55,15 @@ enum MsgCode {
 	, BadHeaderFormat            = 8
 	, RunningExternalToolError   = 9
 	, InternalError              = 10
+	, BadShardOption             = 11
+	, BadReport                  = 12
+	, BadMaxHeaderOffset         = 13
+	, BadTrace                   = 14
+	, BadJobs                    = 15
+	, BadPatch                   = 16
+	, BadCommitRef               = 17
+	, BadRevision                = 18
+	, UnstagedChanges            = 19
 	, GitError                   = 100
 
 	, ProcessingFile             = 500
@@ -34,6 +73,11 @@ enum MsgCode {
 	, PossibleAuthors            = 504
 	, WouldUpdateCopyrightNotice = 505
 	, UpdatedCopyrightNotice     = 506
+	, OutdatedCopyrightNotice    = 507
+	, LogMessagesDropped         = 508
+	, ProfileSummary             = 509
+	, CommittedFiles             = 510
+	, StagedFiles                = 511
 };
 // clang-format on
 
@@ -43,6 +87,14 @@ void setPattern();
 
 }
 
-void init(bool verbose);
+// Enables debug messages, it is also done by init().
+void setVerbose(bool verbose);
+
+// Messages are written asynchronously after initialization. If 'dropOnOverflow' is set, messages
+// are dropped instead of waiting, when the writer can not keep up with them.
+void init(bool verbose, bool dropOnOverflow = false);
+// Writes remaining messages and stops the writer, messages logged after that are written
+// synchronously. Should be called before exit, when no other thread logs.
+void shutdown();
 
 }  // namespace logger
@@ -1,8 +1,11 @@
 #include <QCoreApplication>
 
+#include "concurrency/concurrency.h"
 #include "configuration/RunConfig.h"
 #include "file_processor/FileProcessor.h"
+#include "file_processor/report/report_helpers.h"
 #include "src/logger/log.h"
+#include "src/profiler/profiler.h"
 
 int main(int argc, char *argv[])
 {
@@ -14,10 +17,30 @@ int main(int argc, char *argv[])
 	QCoreApplication::setApplicationVersion(CN_APP_VERSION);
 
 	const RunConfig runConfig(QCoreApplication::arguments());
-	logger::init(runConfig.options() & RunOption::Verbose);
+	logger::init(runConfig.options() & RunOption::Verbose,
+	             runConfig.options() & RunOption::DropLogsOnOverflow);
+
+	if (runConfig.options() & RunOption::MergeShardReports) {
+		const int exitCode =
+		    report_helpers::mergeReports(runConfig.targetPaths(), runConfig.reportPath());
+		logger::shutdown();
+		return exitCode;
+	}
+
+	if (runConfig.options() & RunOption::Profile) {
+		profiler::enable();
+	}
+
+	if (!runConfig.tracePath().isEmpty()) {
+		profiler::enableTrace();
+	}
 
 	FileProcessor fileProcessor(runConfig);
-	fileProcessor.process();
+	const int exitCode = fileProcessor.process();
+	concurrency::waitForDone();
+	profiler::printSummary();
+	profiler::writeTrace(runConfig.tracePath());
 
-	return fileProcessor.isAnyFileUpdated() ? apperror::FilesChanged : apperror::Success;
+	logger::shutdown();
+	return exitCode;
 }
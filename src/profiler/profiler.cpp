@@ -0,0 +1,363 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <vector>
+
+#include "src/logger/log.h"
+
+namespace {
+
+using Msg = logger::MsgCode;
+
+constexpr std::size_t cSlowestFilesCount = 10;
+
+// clang-format off
+constexpr std::array<const char *, profiler::StageCount> cStageNames{
+    "repo-discovery"
+    , "broken-commits"
+    , "read"
+    , "load"
+    , "parse"
+    , "blame"
+    , "list-authors"
+    , "fix"
+    , "serialize"
+    , "write"
+    , "file"
+    , "git-process"
+};
+// clang-format on
+
+struct SlowFile
+{
+	qint64 nsecs;
+	QString path;
+
+	bool operator>(const SlowFile &other) const { return nsecs > other.nsecs; }
+};
+
+struct Span
+{
+	profiler::Stage stage;
+	qint64 startNsecs;
+	qint64 endNsecs;
+	QString detail;
+};
+
+// Written only by the owning thread.
+struct ThreadSamples
+{
+	std::array<std::vector<qint64>, profiler::StageCount> stageNsecs;
+	std::vector<SlowFile> slowestFiles;  // Min-heap by duration.
+	std::vector<Span> spans;
+};
+
+std::atomic_bool gIsEnabled = false;
+std::atomic_bool gIsTraceEnabled = false;
+std::mutex gSamplesMutex;
+std::vector<std::unique_ptr<ThreadSamples>> gSamples;  // Outlive threads, that wrote them.
+
+ThreadSamples &threadSamples()
+{
+	thread_local ThreadSamples *samples = [] {
+		std::lock_guard l(gSamplesMutex);
+		return gSamples.emplace_back(std::make_unique<ThreadSamples>()).get();
+	}();
+	return *samples;
+}
+
+QJsonObject makeThreadNameEvent(int threadId)
+{
+	const auto name = threadId == 0 ? QString("main") : QString("worker %1").arg(threadId);
+	// clang-format off
+	return {
+	    {"name", "thread_name"}
+	    , {"ph", "M"}
+	    , {"pid", 1}
+	    , {"tid", threadId}
+	    , {"args", QJsonObject{{"name", name}}}
+	};
+	// clang-format on
+}
+
+QJsonObject makeSpanEvent(int threadId, const Span &span)
+{
+	constexpr double nsecsPerUsec = 1000.0;
+
+	// clang-format off
+	QJsonObject event{
+	    {"name", cStageNames[span.stage]}
+	    , {"cat", span.stage == profiler::GitProcess ? "git" : "stage"}
+	    , {"ph", "X"}
+	    , {"pid", 1}
+	    , {"tid", threadId}
+	    , {"ts", static_cast<double>(span.startNsecs) / nsecsPerUsec}
+	    , {"dur", static_cast<double>(span.endNsecs - span.startNsecs) / nsecsPerUsec}
+	};
+	// clang-format on
+
+	if (!span.detail.isEmpty()) {
+		event.insert("args", QJsonObject{{"detail", span.detail}});
+	}
+	return event;
+}
+
+double toMs(qint64 nsecs)
+{
+	return static_cast<double>(nsecs) / 1e6;
+}
+
+qint64 percentile(const std::vector<qint64> &sorted, double p)
+{
+	const auto index = static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1));
+	return sorted[index];
+}
+
+void printStages(const std::array<std::vector<qint64>, profiler::StageCount> &stageNsecs)
+{
+	const auto header = QString::asprintf("%-16s %8s %12s %10s %10s %10s %10s", "stage", "count",
+	                                      "total ms", "p50 ms", "p95 ms", "p99 ms", "max ms");
+	CN_INF(Msg::ProfileSummary, qUtf8Printable(header));
+
+	for (int stage = 0; stage < profiler::StageCount; stage++) {
+		const auto &samples = stageNsecs[stage];
+		if (samples.empty()) {
+			continue;
+		}
+
+		qint64 total = 0;
+		for (const auto nsecs : samples) {
+			total += nsecs;
+		}
+
+		const auto line = QString::asprintf(
+		    "%-16s %8zu %12.2f %10.3f %10.3f %10.3f %10.3f", cStageNames[stage], samples.size(),
+		    toMs(total), toMs(percentile(samples, 0.5)), toMs(percentile(samples, 0.95)),
+		    toMs(percentile(samples, 0.99)), toMs(samples.back()));
+		CN_INF(Msg::ProfileSummary, qUtf8Printable(line));
+	}
+}
+
+}  // namespace
+
+namespace profiler {
+
+void enable()
+{
+	nowNsecs();
+	gIsEnabled.store(true, std::memory_order_relaxed);
+}
+
+bool isEnabled()
+{
+	return gIsEnabled.load(std::memory_order_relaxed);
+}
+
+void enableTrace()
+{
+	// Main thread registers first, so its samples get the first thread id.
+	nowNsecs();
+	threadSamples();
+	gIsTraceEnabled.store(true, std::memory_order_relaxed);
+}
+
+bool isTraceEnabled()
+{
+	return gIsTraceEnabled.load(std::memory_order_relaxed);
+}
+
+qint64 nowNsecs()
+{
+	static QElapsedTimer timer = [] {
+		QElapsedTimer t;
+		t.start();
+		return t;
+	}();
+	return timer.nsecsElapsed();
+}
+
+Stage toStage(FileReport::Stage stage)
+{
+	static_assert(FileReport::StageCount == 7, "Update stages mapping");
+	// Indexed by FileReport::Stage.
+	constexpr std::array<Stage, FileReport::StageCount> stages{Read, Load,      Parse, Blame,
+	                                                           Fix,  Serialize, Write};
+	return stages[stage];
+}
+
+void record(Stage stage, qint64 nsecs)
+{
+	if (isEnabled()) {
+		threadSamples().stageNsecs[stage].emplace_back(nsecs);
+	}
+}
+
+void recordFile(const FileReport &report)
+{
+	if (!isEnabled() || report.action == FileReport::Action::Skipped) {
+		return;
+	}
+
+	auto &samples = threadSamples();
+	for (int stage = 0; stage < FileReport::StageCount; stage++) {
+		// Stages, that were not reached, would only skew the percentiles.
+		const auto nsecs = report.stageNsecs[stage];
+		if (nsecs > 0) {
+			samples.stageNsecs[toStage(static_cast<FileReport::Stage>(stage))].emplace_back(nsecs);
+		}
+	}
+	samples.stageNsecs[File].emplace_back(report.totalNsecs);
+
+	auto &slowest = samples.slowestFiles;
+	if (slowest.size() == cSlowestFilesCount) {
+		if (slowest.front().nsecs >= report.totalNsecs) {
+			return;
+		}
+		std::pop_heap(slowest.begin(), slowest.end(), std::greater<>());
+		slowest.pop_back();
+	}
+	slowest.emplace_back(SlowFile{report.totalNsecs, report.path});
+	std::push_heap(slowest.begin(), slowest.end(), std::greater<>());
+}
+
+void traceSpan(Stage stage, qint64 startNsecs, qint64 endNsecs, const QString &detail)
+{
+	if (isTraceEnabled()) {
+		threadSamples().spans.emplace_back(Span{stage, startNsecs, endNsecs, detail});
+	}
+}
+
+void printSummary()
+{
+	if (!isEnabled()) {
+		return;
+	}
+
+	std::array<std::vector<qint64>, StageCount> stageNsecs;
+	std::vector<SlowFile> slowestFiles;
+	{
+		std::lock_guard l(gSamplesMutex);
+		for (const auto &samples : gSamples) {
+			for (int stage = 0; stage < StageCount; stage++) {
+				const auto &from = samples->stageNsecs[stage];
+				stageNsecs[stage].insert(stageNsecs[stage].end(), from.cbegin(), from.cend());
+			}
+			slowestFiles.insert(slowestFiles.end(), samples->slowestFiles.cbegin(),
+			                    samples->slowestFiles.cend());
+		}
+	}
+
+	for (auto &samples : stageNsecs) {
+		std::sort(samples.begin(), samples.end());
+	}
+
+	CN_INF(Msg::ProfileSummary,
+	       "Profile of " << stageNsecs[File].size() << " files, wall time "
+	                     << QString::number(toMs(nowNsecs()), 'f', 2) << " ms:");
+	printStages(stageNsecs);
+
+	const auto &gitNsecs = stageNsecs[GitProcess];
+	qint64 gitTotal = 0;
+	for (const auto nsecs : gitNsecs) {
+		gitTotal += nsecs;
+	}
+	CN_INF(Msg::ProfileSummary,
+	       "Git subprocesses: " << gitNsecs.size() << ", total wall time "
+	                            << QString::number(toMs(gitTotal), 'f', 2) << " ms.");
+
+	const auto slowestCount = std::min(slowestFiles.size(), cSlowestFilesCount);
+	const auto slowestEnd =
+	    std::next(slowestFiles.begin(), static_cast<std::ptrdiff_t>(slowestCount));
+	std::partial_sort(slowestFiles.begin(), slowestEnd, slowestFiles.end(), std::greater<>());
+	CN_INF(Msg::ProfileSummary, "Slowest files:");
+	for (std::size_t i = 0; i < slowestCount; i++) {
+		const auto duration = QString::asprintf("%10.3f ms ", toMs(slowestFiles[i].nsecs));
+		CN_INF(Msg::ProfileSummary, qUtf8Printable(duration) << slowestFiles[i].path);
+	}
+}
+
+void writeTrace(const QString &path)
+{
+	if (!isTraceEnabled()) {
+		return;
+	}
+
+	QFile file(path);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+		CN_ERR(Msg::BadTrace, "Error opening trace " << path << ": " << file.errorString());
+		return;
+	}
+
+	// Events are written one by one, so the whole trace is never built in memory.
+	std::lock_guard l(gSamplesMutex);
+	file.write("{\"traceEvents\":[\n");
+	bool isFirst = true;
+	const auto writeEvent = [&file, &isFirst](const QJsonObject &event) {
+		if (!isFirst) {
+			file.write(",\n");
+		}
+		file.write(QJsonDocument(event).toJson(QJsonDocument::Compact));
+		isFirst = false;
+	};
+
+	for (int threadId = 0; threadId < static_cast<int>(gSamples.size()); threadId++) {
+		const auto &spans = gSamples[threadId]->spans;
+		if (spans.empty()) {
+			continue;
+		}
+
+		writeEvent(makeThreadNameEvent(threadId));
+		for (const auto &span : spans) {
+			writeEvent(makeSpanEvent(threadId, span));
+		}
+	}
+	file.write("\n],\"displayTimeUnit\":\"ms\"}\n");
+
+	if (file.error() != QFileDevice::NoError) {
+		CN_ERR(Msg::BadTrace, "Error writing trace " << path << ": " << file.errorString());
+	}
+}
+
+ScopedTimer::ScopedTimer(Stage stage)
+    : m_stage(stage)
+{
+	if (isEnabled() || isTraceEnabled()) {
+		m_startNsecs = nowNsecs();
+	}
+}
+
+ScopedTimer::~ScopedTimer()
+{
+	if (m_startNsecs >= 0) {
+		const auto endNsecs = nowNsecs();
+		record(m_stage, endNsecs - m_startNsecs);
+		traceSpan(m_stage, m_startNsecs, endNsecs);
+	}
+}
+
+ScopedSpan::ScopedSpan(Stage stage, QString detail)
+    : m_stage(stage)
+    , m_detail(std::move(detail))
+{
+	if (isTraceEnabled()) {
+		m_startNsecs = nowNsecs();
+	}
+}
+
+ScopedSpan::~ScopedSpan()
+{
+	if (m_startNsecs >= 0) {
+		traceSpan(m_stage, m_startNsecs, nowNsecs(), m_detail);
+	}
+}
+
+}  // namespace profiler
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <QString>
+
+#include "src/file_processor/report/FileReport.h"
+
+// Run profile, that is collected with --profile, and trace of worker activity, that is written with
+// --trace. Samples and spans are stored per thread, so recording does not lock, and are merged only
+// when the summary or the trace is written.
+namespace profiler {
+
+enum Stage {
+	RepoDiscovery,
+	BrokenCommits,
+	Read,
+	Load,
+	Parse,
+	Blame,
+	ListAuthors,
+	Fix,  // Without blaming.
+	Serialize,
+	Write,
+	File,  // Whole file processing.
+	GitProcess,
+	StageCount
+};
+
+void enable();
+[[nodiscard]] bool isEnabled();
+void enableTrace();
+[[nodiscard]] bool isTraceEnabled();
+
+// Monotonic time, that is used for samples and spans.
+[[nodiscard]] qint64 nowNsecs();
+[[nodiscard]] Stage toStage(FileReport::Stage stage);
+
+void record(Stage stage, qint64 nsecs);
+// Records stages of the processed file and remembers it, if it is one of the slowest.
+void recordFile(const FileReport &report);
+
+// Records a span of the current thread, if tracing is enabled. 'detail' is shown in its arguments.
+void traceSpan(Stage stage, qint64 startNsecs, qint64 endNsecs, const QString &detail = {});
+
+// Prints latency percentiles and totals of every stage, slowest files and git subprocess stats.
+// Must be called, when no file is being processed.
+void printSummary();
+
+// Writes spans of every thread as Chrome trace events (chrome://tracing, ui.perfetto.dev).
+// Must be called, when no file is being processed.
+void writeTrace(const QString &path);
+
+// Records time between construction and destruction as a sample, if profiling is enabled, and as a
+// span, if tracing is enabled.
+struct ScopedTimer
+{
+	explicit ScopedTimer(Stage stage);
+	~ScopedTimer();
+	ScopedTimer(const ScopedTimer &) = delete;
+
+private:
+	Stage m_stage;
+	qint64 m_startNsecs = -1;
+};
+
+// Records time between construction and destruction only as a span, for stages, which samples are
+// taken from FileReport.
+struct ScopedSpan
+{
+	explicit ScopedSpan(Stage stage, QString detail = {});
+	~ScopedSpan();
+	ScopedSpan(const ScopedSpan &) = delete;
+
+private:
+	Stage m_stage;
+	QString m_detail;
+	qint64 m_startNsecs = -1;
+};
+
+}  // namespace profiler
@@ -0,0 +1,487 @@
+#include <QtTest>
+
+#include <QRegularExpression>
+
+#include "../src/file_processor/git/git_helpers.h"
+#include "../src/file_processor/parser/Header.h"
+#include "../src/file_processor/parser/header_helpers.h"
+#include "../src/file_processor/parser/header_utils.h"
+#include "../src/logger/log.h"
+
+// Debug logging, as it was done before level gating: the message is always formatted and is
+// dropped by the message handler afterwards.
+#define LEGACY_CN_DEBUG(msg) qDebug() << "[D0]" << msg
+
+namespace {
+
+// Header line parsing, as it was done before header_helpers::tokenizeField: a regex is compiled
+// per file and every line is converted to QString to be matched.
+int parseFieldsWithRegex(const std::vector<std::string_view> &lines, std::string_view start)
+{
+	// clang-format off
+	static const QLatin1String pattern("^" "%1" "(?P<fieldData> (?P<fieldName>" "%2" ") +(?P<fieldValue>.*))?$");
+	// clang-format on
+
+	const auto qStart = QString::fromLatin1(start.data(), static_cast<int>(start.size()));
+	QRegularExpression regex(pattern.arg(QRegularExpression::escape(qStart),
+	                                     "File|Author|Copyright|This file is part of"));
+
+	int fields = 0;
+	for (const auto line : lines) {
+		const auto qLine = QString::fromUtf8(line.data(), static_cast<int>(line.size()));
+		const auto match = regex.match(qLine);
+		if (match.hasMatch() && !match.captured("fieldData").isEmpty()) {
+			fields += !match.captured("fieldValue").isEmpty();
+		}
+	}
+	return fields;
+}
+
+int parseFieldsWithTokenizer(const std::vector<std::string_view> &lines, std::string_view start)
+{
+	int fields = 0;
+	for (const auto line : lines) {
+		const auto token = header_helpers::tokenizeField(line, start);
+		if (token.has_value() && token->type != header_fields::FieldType::Default) {
+			fields += !token->value.empty();
+		}
+	}
+	return fields;
+}
+
+std::string makeHeaderBody(std::string_view start, int authors)
+{
+	std::string body;
+	body.append(start).append(" File      GeneratedFile.cpp\n");
+	for (int i = 0; i < authors; i++) {
+		body.append(start).append(" Author    Author Name").append(std::to_string(i)).append("\n");
+	}
+	body.append(start).append(" Copyright (c) 2022, Inc. All Rights Reserved.\n");
+	body.append(start).append("\n");
+	body.append(start).append(" This file is part of Component.");
+	return body;
+}
+
+QByteArray makeFileContent(std::string_view ext, int authors, int codeLines = 1000,
+                           bool withHeader = true)
+{
+	std::string content;
+	if (withHeader) {
+		content.append(header_utils::prefixMap[ext]);
+		content.append(makeHeaderBody(header_utils::startMap[ext], authors));
+		content.append(header_utils::suffixMap[ext]);
+	}
+	for (int i = 0; i < codeLines; i++) {
+		content.append("int function").append(std::to_string(i)).append("();\n");
+	}
+	return QByteArray::fromStdString(content);
+}
+
+QString makeHash(int commit)
+{
+	return QString::number(commit, 16).rightJustified(40, '0');
+}
+
+QString makeAuthor(int author)
+{
+	return QString("Author Name%1").arg(author);
+}
+
+// Output of 'git blame -l -f', where lines are spread over commits in runs of 8 lines.
+QByteArray makeBlameOutput(int lines, int commits, int authors)
+{
+	QByteArray output;
+	for (int line = 0; line < lines; line++) {
+		const int commit = (line / 8) % commits;
+		output += makeHash(commit).toLatin1() + " src/GeneratedFile.cpp ("
+		    + makeAuthor(commit % authors).toLatin1() + " 2022-01-01 10:00:00 +0000 "
+		    + QByteArray::number(line + 1) + ") int function();\n";
+	}
+	return output;
+}
+
+GitBlame makeBlame(int lines, int commits, int authors)
+{
+	GitBlame blame;
+	for (int commit = 0; commit < commits; commit++) {
+		blame.commits.emplace_back(makeHash(commit));
+		blame.commitAuthors.emplace_back(static_cast<GitBlame::Id>(commit % authors));
+	}
+	for (int author = 0; author < authors; author++) {
+		blame.authors.emplace_back(makeAuthor(author));
+	}
+	for (int line = 0; line < lines; line++) {
+		blame.lines.emplace_back(static_cast<GitBlame::Id>((line / 8) % commits));
+	}
+	return blame;
+}
+
+// Shares of authors decrease geometrically, so only some of them pass the filter.
+std::unordered_map<QString, double> makeAuthorShares(int authors)
+{
+	std::unordered_map<QString, double> shares;
+	double sum = 0;
+	for (int author = 0; author < authors; author++) {
+		const double share = 1.0 / (author + 1);
+		shares[makeAuthor(author)] = share;
+		sum += share;
+	}
+	for (auto &[name, share] : shares) {
+		share /= sum;
+	}
+	return shares;
+}
+
+RunConfig makeRunConfig(const QString &targetPath)
+{
+	return RunConfig({QCoreApplication::applicationFilePath(), targetPath});
+}
+
+// Loading and parsing part of processFile with its debug messages.
+template <bool isGated>
+bool processFileWithLogging(const Context &ctx, const QByteArray &content)
+{
+	Header header(ctx, content, GitRepository(ctx.targetRepoRootPath));
+	header.load();
+
+	if constexpr (isGated) {
+		CN_DEBUG("Processing file" << ctx.targetPath << "from" << ctx.targetRepoRootPath);
+	} else {
+		LEGACY_CN_DEBUG("Processing file" << ctx.targetPath << "from" << ctx.targetRepoRootPath);
+	}
+
+	if (header.isEmpty()) {
+		return false;
+	}
+
+	header.parse();
+	if constexpr (isGated) {
+		CN_DEBUG("Header found in " << ctx.targetPath << '.');
+		CN_DEBUG("Header in file" << ctx.targetPath << "will not be updated.");
+	} else {
+		LEGACY_CN_DEBUG("Header found in " << ctx.targetPath << '.');
+		LEGACY_CN_DEBUG("Header in file" << ctx.targetPath << "will not be updated.");
+	}
+	return true;
+}
+
+}  // namespace
+
+class HeaderParserBenchmark : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void bench_ParseFields_data();
+	void bench_ParseFields();
+	void bench_ProcessFileLogging_data();
+	void bench_ProcessFileLogging();
+	void bench_HeaderRange_data();
+	void bench_HeaderRange();
+	void bench_SplitString_data();
+	void bench_SplitString();
+	void bench_HeaderLineRange_data();
+	void bench_HeaderLineRange();
+	void bench_HeaderParse_data();
+	void bench_HeaderParse();
+	void bench_HeaderSerialize_data();
+	void bench_HeaderSerialize();
+	void bench_ParseBlame_data();
+	void bench_ParseBlame();
+	void bench_CollectGitBlameStatistic_data();
+	void bench_CollectGitBlameStatistic();
+	void bench_ListGitAuthors_data();
+	void bench_ListGitAuthors();
+};
+
+void HeaderParserBenchmark::initTestCase()
+{
+	logger::environment::setPattern();
+	logger::init(false);
+}
+
+void HeaderParserBenchmark::cleanupTestCase()
+{
+	logger::shutdown();
+}
+
+void HeaderParserBenchmark::bench_ParseFields_data()
+{
+	QTest::addColumn<bool>("useRegex");
+	QTest::addColumn<int>("authors");
+
+	for (const int authors : {1, 8, 64}) {
+		QTest::addRow("regex/%d-authors", authors) << true << authors;
+		QTest::addRow("tokenizer/%d-authors", authors) << false << authors;
+	}
+}
+
+void HeaderParserBenchmark::bench_ParseFields()
+{
+	QFETCH(bool, useRegex);
+	QFETCH(int, authors);
+
+	const auto start = header_utils::startMap["cpp"];
+	const auto body = makeHeaderBody(start, authors);
+	const auto lines = header_helpers::splitString(body, "\n");
+	const int expectedFields = authors + 3;
+
+	int fields = 0;
+	if (useRegex) {
+		QBENCHMARK {
+			fields = parseFieldsWithRegex(lines, start);
+		}
+	} else {
+		QBENCHMARK {
+			fields = parseFieldsWithTokenizer(lines, start);
+		}
+	}
+
+	QCOMPARE(fields, expectedFields);
+}
+
+void HeaderParserBenchmark::bench_ProcessFileLogging_data()
+{
+	QTest::addColumn<bool>("isGated");
+
+	QTest::addRow("legacy-debug") << false;
+	QTest::addRow("gated-debug") << true;
+}
+
+void HeaderParserBenchmark::bench_ProcessFileLogging()
+{
+	QFETCH(bool, isGated);
+
+	const QString targetPath = "/not/used/for/bench/GeneratedFile.cpp";
+	const Context ctx{targetPath, "/not/used/for/bench", makeRunConfig(targetPath)};
+	const auto content = makeFileContent("cpp", 8);
+
+	bool isHeaderFound = false;
+	if (isGated) {
+		QBENCHMARK {
+			isHeaderFound = processFileWithLogging<true>(ctx, content);
+		}
+	} else {
+		QBENCHMARK {
+			isHeaderFound = processFileWithLogging<false>(ctx, content);
+		}
+	}
+
+	QVERIFY(isHeaderFound);
+}
+
+void HeaderParserBenchmark::bench_HeaderRange_data()
+{
+	QTest::addColumn<int>("codeLines");
+	QTest::addColumn<bool>("withHeader");
+
+	for (const int codeLines : {100, 10'000, 1'000'000}) {
+		QTest::addRow("header/%d-lines", codeLines) << codeLines << true;
+		QTest::addRow("no-header/%d-lines", codeLines) << codeLines << false;
+	}
+}
+
+void HeaderParserBenchmark::bench_HeaderRange()
+{
+	QFETCH(int, codeLines);
+	QFETCH(bool, withHeader);
+
+	const auto content = makeFileContent("cpp", 8, codeLines, withHeader);
+	const auto contentView = std::string_view(content.constData(), content.size());
+	const auto prefix = header_utils::prefixMap["cpp"];
+	const auto suffix = header_utils::suffixMap["cpp"];
+
+	constexpr auto maxHeaderOffset = static_cast<std::size_t>(appconst::cMaxHeaderOffset);
+
+	header_helpers::HeaderRangeOpt range;
+	QBENCHMARK {
+		range = header_helpers::headerRange(contentView, prefix, suffix, maxHeaderOffset);
+	}
+
+	QCOMPARE(range.has_value(), withHeader);
+}
+
+void HeaderParserBenchmark::bench_SplitString_data()
+{
+	QTest::addColumn<int>("codeLines");
+
+	for (const int codeLines : {10, 1'000, 100'000}) {
+		QTest::addRow("%d-lines", codeLines) << codeLines;
+	}
+}
+
+void HeaderParserBenchmark::bench_SplitString()
+{
+	QFETCH(int, codeLines);
+
+	const auto content = makeFileContent("cpp", 0, codeLines, false);
+	const auto contentView = std::string_view(content.constData(), content.size());
+
+	std::size_t lineCount = 0;
+	QBENCHMARK {
+		lineCount = header_helpers::splitString(contentView, "\n").size();
+	}
+
+	QCOMPARE(lineCount, static_cast<std::size_t>(codeLines) + 1);
+}
+
+void HeaderParserBenchmark::bench_HeaderLineRange_data()
+{
+	QTest::addColumn<int>("authors");
+
+	for (const int authors : {1, 64, 4096}) {
+		QTest::addRow("%d-authors", authors) << authors;
+	}
+}
+
+void HeaderParserBenchmark::bench_HeaderLineRange()
+{
+	QFETCH(int, authors);
+
+	const auto content = makeFileContent("cpp", authors);
+	const auto contentView = std::string_view(content.constData(), content.size());
+	const auto range = header_helpers::headerRange(contentView, header_utils::prefixMap["cpp"],
+	                                               header_utils::suffixMap["cpp"]);
+	QVERIFY(range.has_value());
+
+	std::pair<std::size_t, std::size_t> lineRange;
+	QBENCHMARK {
+		lineRange = header_helpers::headerLineRange(contentView, range.value());
+	}
+
+	QVERIFY(lineRange.second > static_cast<std::size_t>(authors));
+}
+
+void HeaderParserBenchmark::bench_HeaderParse_data()
+{
+	QTest::addColumn<int>("authors");
+
+	for (const int authors : {1, 8, 64}) {
+		QTest::addRow("%d-authors", authors) << authors;
+	}
+}
+
+void HeaderParserBenchmark::bench_HeaderParse()
+{
+	QFETCH(int, authors);
+
+	const QString targetPath = "/not/used/for/bench/GeneratedFile.cpp";
+	const Context ctx{targetPath, "/not/used/for/bench", makeRunConfig(targetPath)};
+	const auto content = makeFileContent("cpp", authors);
+
+	QBENCHMARK {
+		Header header(ctx, content, GitRepository(ctx.targetRepoRootPath));
+		header.load();
+		header.parse();
+	}
+}
+
+void HeaderParserBenchmark::bench_HeaderSerialize_data()
+{
+	bench_HeaderParse_data();
+}
+
+void HeaderParserBenchmark::bench_HeaderSerialize()
+{
+	QFETCH(int, authors);
+
+	const QString targetPath = "/not/used/for/bench/GeneratedFile.cpp";
+	const Context ctx{targetPath, "/not/used/for/bench", makeRunConfig(targetPath)};
+	const auto content = makeFileContent("cpp", authors);
+
+	Header header(ctx, content, GitRepository(ctx.targetRepoRootPath));
+	header.load();
+	header.parse();
+
+	QByteArray serialized;
+	QBENCHMARK {
+		serialized = header.serialize();
+	}
+
+	QVERIFY(content.startsWith(serialized));
+}
+
+void HeaderParserBenchmark::bench_ParseBlame_data()
+{
+	QTest::addColumn<int>("lines");
+	QTest::addColumn<int>("commits");
+
+	for (const int lines : {1'000, 10'000}) {
+		for (const int commits : {10, 1'000}) {
+			QTest::addRow("%d-lines/%d-commits", lines, commits) << lines << commits;
+		}
+	}
+}
+
+void HeaderParserBenchmark::bench_ParseBlame()
+{
+	QFETCH(int, lines);
+	QFETCH(int, commits);
+
+	const auto output = makeBlameOutput(lines, commits, 16);
+
+	GitBlame blame;
+	QBENCHMARK {
+		blame = git_helpers::parseBlame(output);
+	}
+
+	QCOMPARE(blame.lines.size(), static_cast<std::size_t>(lines));
+}
+
+void HeaderParserBenchmark::bench_CollectGitBlameStatistic_data()
+{
+	QTest::addColumn<int>("lines");
+	QTest::addColumn<int>("commits");
+
+	for (const int lines : {1'000, 100'000}) {
+		for (const int commits : {10, 1'000}) {
+			QTest::addRow("%d-lines/%d-commits", lines, commits) << lines << commits;
+		}
+	}
+}
+
+void HeaderParserBenchmark::bench_CollectGitBlameStatistic()
+{
+	QFETCH(int, lines);
+	QFETCH(int, commits);
+
+	const auto blame = makeBlame(lines, commits, 16);
+	const std::set<QString> skipCommits{makeHash(0)};
+	const AuthorAliasesMap aliases{{makeAuthor(1), makeAuthor(2)}};
+
+	std::unordered_map<QString, double> statistic;
+	QBENCHMARK {
+		statistic = header_helpers::collectGitBlameStatistic(blame, skipCommits, {0, 0}, aliases);
+	}
+
+	QVERIFY(!statistic.empty());
+}
+
+void HeaderParserBenchmark::bench_ListGitAuthors_data()
+{
+	QTest::addColumn<int>("authors");
+
+	for (const int authors : {4, 32, 256}) {
+		QTest::addRow("%d-authors", authors) << authors;
+	}
+}
+
+void HeaderParserBenchmark::bench_ListGitAuthors()
+{
+	QFETCH(int, authors);
+
+	const auto shares = makeAuthorShares(authors);
+
+	std::vector<QString> listed;
+	QBENCHMARK {
+		listed = header_helpers::listGitAuthors(shares);
+	}
+
+	QVERIFY(!listed.empty());
+}
+
+QTEST_GUILESS_MAIN(HeaderParserBenchmark)
+
+#include "bench_HeaderParser.moc"
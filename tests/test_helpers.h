@@ -0,0 +1,125 @@
+#pragma once
+
+#include <QtTest>
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QStandardPaths>
+#include <optional>
+
+#include "../src/concurrency/concurrency.h"
+#include "../src/configuration/RunConfig.h"
+#include "../src/file_processor/FileProcessor.h"
+
+// Repositories, files and runs of the application, that tests share.
+namespace test_helpers {
+
+inline bool hasGit()
+{
+	return !QStandardPaths::findExecutable("git").isEmpty();
+}
+
+// Returns output of git, that is run in 'workingDir', or nothing, if it fails.
+inline std::optional<QByteArray> runGit(const QStringList &arguments, const QString &workingDir,
+                                        const QByteArray &input = {})
+{
+	QProcess process;
+	process.setWorkingDirectory(workingDir);
+	process.start("git", arguments);
+	if (!process.waitForStarted()) {
+		return std::nullopt;
+	}
+
+	process.write(input);
+	process.closeWriteChannel();
+	if (!process.waitForFinished() || process.exitStatus() != QProcess::NormalExit
+	    || process.exitCode() != 0) {
+		return std::nullopt;
+	}
+	return process.readAllStandardOutput();
+}
+
+// Committer and line endings are set, so results do not depend on the user's configuration.
+inline bool initRepository(const QString &path)
+{
+	return QDir().mkpath(path) && runGit({"init", "-q", "."}, path)
+	    && runGit({"config", "user.name", "Bill Gates"}, path)
+	    && runGit({"config", "user.email", "bill@example.com"}, path)
+	    && runGit({"config", "core.autocrlf", "false"}, path);
+}
+
+inline bool commitAll(const QString &repoPath)
+{
+	return runGit({"add", "-A"}, repoPath) && runGit({"commit", "-q", "-m", "Test"}, repoPath);
+}
+
+// Files are written and read in binary mode, unlike file_utils::readFile().
+inline bool writeFile(const QString &path, const QByteArray &content)
+{
+	QDir().mkpath(QFileInfo(path).path());
+	QFile file(path);
+	return file.open(QIODevice::WriteOnly | QIODevice::Truncate)
+	    && file.write(content) == content.size();
+}
+
+inline QByteArray readFile(const QString &path)
+{
+	QFile file(path);
+	return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+// Returns a C++ header, that names 'fileName' as the file, so it is outdated with
+// --update-filename in every file, that has a different name.
+inline QByteArray makeHeader(const QByteArray &fileName)
+{
+	return "/******************************************************************************\n"
+	       "**\n"
+	       "** File      "
+	    + fileName
+	    + "\n"
+	      "** Copyright (c) 2020, Inc. All Rights Reserved.\n"
+	      "**\n"
+	      "******************************************************************************/\n"
+	      "\n";
+}
+
+// Returns records of a --report, the summary is the last one.
+inline std::vector<QJsonObject> readReport(const QString &path)
+{
+	std::vector<QJsonObject> records;
+	for (const auto &line : readFile(path).split('\n')) {
+		if (!line.isEmpty()) {
+			records.emplace_back(QJsonDocument::fromJson(line).object());
+		}
+	}
+	return records;
+}
+
+// Static configuration is loaded once per process, so every test executable writes it once and
+// passes it to every run.
+inline QString writeStaticConfig(const QString &dirPath)
+{
+	const auto path = dirPath + "/static_config.json";
+	writeFile(path, R"({
+	    "author_aliases": {},
+	    "copyright_field_template": "Copyright (C) %CURRENT_YEAR% Company Inc.",
+	    "excluded_path_sections": []
+	})");
+	return path;
+}
+
+// Runs the application like main() does, besides merging of shard reports, and returns its exit
+// code.
+inline int runApp(QStringList arguments)
+{
+	qputenv("LINT_ENABLE_COPYRIGHT_UPDATE", "");
+	arguments.prepend(QCoreApplication::applicationFilePath());
+	const RunConfig config(arguments);
+	FileProcessor fileProcessor(config);
+	const int exitCode = fileProcessor.process();
+	concurrency::waitForDone();
+	return exitCode;
+}
+
+}  // namespace test_helpers
@@ -0,0 +1,152 @@
+#include <QtTest>
+
+#include <mutex>
+#include <vector>
+
+#include "../src/concurrency/concurrency.h"
+#include "../src/logger/log.h"
+
+namespace {
+
+using concurrency::Limiter;
+
+struct SlotAwaiter
+{
+	Limiter &limiter;
+
+	[[nodiscard]] bool await_ready() const noexcept { return false; }
+	[[nodiscard]] bool await_suspend(std::coroutine_handle<> handle)
+	{
+		return !limiter.acquireOrQueue(handle);
+	}
+	void await_resume() const noexcept {}
+};
+
+// Ids of tasks in the order, in which they got their slots.
+struct Acquisitions
+{
+	void add(int id)
+	{
+		const std::lock_guard lock(mutex);
+		ids.emplace_back(id);
+	}
+
+	std::vector<int> get() const
+	{
+		const std::lock_guard lock(mutex);
+		return ids;
+	}
+
+	std::size_t size() const { return get().size(); }
+
+	mutable std::mutex mutex;
+	std::vector<int> ids;
+};
+
+// Queued tasks are resumed on the pool, when they get a slot.
+concurrency::Task acquire(Limiter &limiter, int id, Acquisitions &acquisitions)
+{
+	co_await SlotAwaiter{limiter};
+	acquisitions.add(id);
+}
+
+}  // namespace
+
+class ConcurrencyTest : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void test_WaitersGetSlotsInOrder();
+	void test_ShrunkLimitHoldsWaiters();
+	void test_GrownLimitWakesWaiters();
+	void test_LimitIsPositive();
+};
+
+void ConcurrencyTest::initTestCase()
+{
+	logger::environment::setPattern();
+	concurrency::init(2, 0, false);
+}
+
+void ConcurrencyTest::cleanupTestCase()
+{
+	concurrency::waitForDone();
+}
+
+void ConcurrencyTest::test_WaitersGetSlotsInOrder()
+{
+	Limiter limiter(2);
+	Acquisitions acquisitions;
+	for (int id = 0; id < 4; id++) {
+		acquire(limiter, id, acquisitions);
+	}
+	QCOMPARE(acquisitions.get(), (std::vector<int>{0, 1}));
+
+	// A released slot is handed to the first waiter, so the number of taken slots stays the same.
+	limiter.release();
+	QTRY_COMPARE(acquisitions.size(), std::size_t(3));
+	limiter.release();
+	QTRY_COMPARE(acquisitions.get(), (std::vector<int>{0, 1, 2, 3}));
+
+	acquire(limiter, 4, acquisitions);
+	QCOMPARE(acquisitions.size(), std::size_t(4));
+	limiter.release();
+	QTRY_COMPARE(acquisitions.size(), std::size_t(5));
+}
+
+void ConcurrencyTest::test_ShrunkLimitHoldsWaiters()
+{
+	Limiter limiter(3);
+	Acquisitions acquisitions;
+	for (int id = 0; id < 4; id++) {
+		acquire(limiter, id, acquisitions);
+	}
+	QCOMPARE(acquisitions.size(), std::size_t(3));
+
+	// Taken slots are not revoked, but the waiter gets a slot only below the new limit.
+	limiter.setLimit(1);
+	QCOMPARE(limiter.limit(), 1);
+	limiter.release();
+	limiter.release();
+	QTest::qWait(50);
+	QCOMPARE(acquisitions.size(), std::size_t(3));
+
+	limiter.release();
+	QTRY_COMPARE(acquisitions.get(), (std::vector<int>{0, 1, 2, 3}));
+}
+
+void ConcurrencyTest::test_GrownLimitWakesWaiters()
+{
+	Limiter limiter(1);
+	Acquisitions acquisitions;
+	for (int id = 0; id < 3; id++) {
+		acquire(limiter, id, acquisitions);
+	}
+	QCOMPARE(acquisitions.size(), std::size_t(1));
+
+	// Woken waiters run in parallel, so their order is not checked.
+	limiter.setLimit(3);
+	QCOMPARE(limiter.limit(), 3);
+	QTRY_COMPARE(acquisitions.size(), std::size_t(3));
+
+	// Every slot is taken, so a new task waits.
+	acquire(limiter, 3, acquisitions);
+	QCOMPARE(acquisitions.size(), std::size_t(3));
+	limiter.release();
+	QTRY_COMPARE(acquisitions.size(), std::size_t(4));
+}
+
+void ConcurrencyTest::test_LimitIsPositive()
+{
+	Limiter limiter(0);
+	QCOMPARE(limiter.limit(), 1);
+	limiter.setLimit(-1);
+	QCOMPARE(limiter.limit(), 1);
+}
+
+QTEST_GUILESS_MAIN(ConcurrencyTest)
+
+#include "tst_ConcurrencyTest.moc"
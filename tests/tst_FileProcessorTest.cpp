@@ -0,0 +1,208 @@
+#include <QtTest>
+
+#include <QTemporaryDir>
+
+#include "../src/constants.h"
+#include "../src/logger/log.h"
+#include "test_helpers.h"
+
+namespace {
+
+using namespace appconst::json::report;
+
+// Returns the number of records of the report, that have 'action'.
+int countActions(const std::vector<QJsonObject> &records, const QString &action)
+{
+	return static_cast<int>(std::count_if(records.cbegin(), records.cend(), [&](const auto &r) {
+		return r.value(cAction).toString() == action;
+	}));
+}
+
+}  // namespace
+
+class FileProcessorTest : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+	void test_CheckExitCode_data();
+	void test_CheckExitCode();
+	void test_CheckCancelsPendingFiles();
+	void test_OverlappingTargets();
+	void test_UnrelatedRepositories();
+
+private:
+	// Returns the path of a new repository, that has 'fileCount' committed files.
+	QString makeRepository(const QString &name, int fileCount, bool isOutdated);
+	QStringList runArguments(const QStringList &arguments, const QStringList &targetPaths) const;
+
+private:
+	QTemporaryDir m_dir;
+	QString m_staticConfigPath;
+};
+
+void FileProcessorTest::initTestCase()
+{
+	logger::environment::setPattern();
+	QVERIFY(m_dir.isValid());
+	m_staticConfigPath = test_helpers::writeStaticConfig(m_dir.path());
+}
+
+QString FileProcessorTest::makeRepository(const QString &name, int fileCount, bool isOutdated)
+{
+	const auto repoPath = m_dir.filePath(name);
+	if (!test_helpers::initRepository(repoPath)) {
+		return {};
+	}
+
+	for (int i = 0; i < fileCount; i++) {
+		const auto fileName = QString("file%1.cpp").arg(i).toUtf8();
+		const auto content = test_helpers::makeHeader(isOutdated ? "old.cpp" : fileName)
+		    + "int value" + QByteArray::number(i) + ";\n";
+		if (!test_helpers::writeFile(repoPath + '/' + fileName, content)) {
+			return {};
+		}
+	}
+	return test_helpers::commitAll(repoPath) ? repoPath : QString();
+}
+
+QStringList FileProcessorTest::runArguments(const QStringList &arguments,
+                                            const QStringList &targetPaths) const
+{
+	return QStringList{"--update-filename", "--static-config", m_staticConfigPath} + arguments
+	    + targetPaths;
+}
+
+void FileProcessorTest::test_CheckExitCode_data()
+{
+	QTest::addColumn<QStringList>("arguments");
+	QTest::addColumn<bool>("isOutdated");
+	QTest::addColumn<int>("exitCode");
+
+	// clang-format off
+	QTest::newRow("check-outdated") << QStringList{"--check"} << true
+	                                << static_cast<int>(apperror::FilesChanged);
+	QTest::newRow("check-up-to-date") << QStringList{"--check"} << false
+	                                  << static_cast<int>(apperror::Success);
+	QTest::newRow("check-all-outdated") << QStringList{"--check-all"} << true
+	                                    << static_cast<int>(apperror::FilesChanged);
+	QTest::newRow("dry-outdated") << QStringList{"--dry"} << true
+	                              << static_cast<int>(apperror::Success);
+	// clang-format on
+}
+
+void FileProcessorTest::test_CheckExitCode()
+{
+	if (!test_helpers::hasGit()) {
+		QSKIP("git is not found.");
+	}
+
+	QFETCH(QStringList, arguments);
+	QFETCH(bool, isOutdated);
+	QFETCH(int, exitCode);
+
+	const auto repoPath = makeRepository(QTest::currentDataTag(), 1, isOutdated);
+	QVERIFY(!repoPath.isEmpty());
+	const auto filePath = repoPath + "/file0.cpp";
+	const auto content = test_helpers::readFile(filePath);
+
+	QCOMPARE(test_helpers::runApp(runArguments(arguments, {repoPath})), exitCode);
+	// Files are only checked.
+	QCOMPARE(test_helpers::readFile(filePath), content);
+}
+
+void FileProcessorTest::test_CheckCancelsPendingFiles()
+{
+	if (!test_helpers::hasGit()) {
+		QSKIP("git is not found.");
+	}
+
+	constexpr int cFileCount = 8;
+	const auto repoPath = makeRepository("cancel", cFileCount, true);
+	QVERIFY(!repoPath.isEmpty());
+	const auto reportPath = m_dir.filePath("cancel.jsonl");
+
+	// Files are processed one by one, so every file after the first outdated one is skipped or
+	// is not started at all.
+	const QStringList checkArguments = {"--check", "--jobs", "1", "--report", reportPath};
+	QCOMPARE(test_helpers::runApp(runArguments(checkArguments, {repoPath})),
+	         static_cast<int>(apperror::FilesChanged));
+	auto records = test_helpers::readReport(reportPath);
+	QVERIFY(!records.empty());
+	records.pop_back();
+	QCOMPARE(countActions(records, "would-update"), 1);
+	QCOMPARE(countActions(records, "skipped"), static_cast<int>(records.size()) - 1);
+
+	// Files of a later run in the same process are not cancelled.
+	const QStringList checkAllArguments = {"--check-all", "--jobs", "1", "--report", reportPath};
+	QCOMPARE(test_helpers::runApp(runArguments(checkAllArguments, {repoPath})),
+	         static_cast<int>(apperror::FilesChanged));
+	records = test_helpers::readReport(reportPath);
+	QCOMPARE(countActions(records, "would-update"), cFileCount);
+}
+
+void FileProcessorTest::test_OverlappingTargets()
+{
+	if (!test_helpers::hasGit()) {
+		QSKIP("git is not found.");
+	}
+
+	const auto repoPath = makeRepository("overlap", 3, true);
+	QVERIFY(!repoPath.isEmpty());
+	const auto reportPath = m_dir.filePath("overlap.jsonl");
+
+	// Files are named by several targets, but are processed once.
+	const QStringList targetPaths = {repoPath, repoPath + "/file0.cpp",
+	                                 repoPath + "/sub/../file1.cpp", repoPath};
+	const QStringList arguments = {"--check-all", "--report", reportPath};
+	QCOMPARE(test_helpers::runApp(runArguments(arguments, targetPaths)),
+	         static_cast<int>(apperror::FilesChanged));
+
+	auto records = test_helpers::readReport(reportPath);
+	QVERIFY(!records.empty());
+	records.pop_back();
+	QStringList paths;
+	for (const auto &record : records) {
+		paths.append(record.value(cPath).toString());
+	}
+	paths.sort();
+	QCOMPARE(paths, (QStringList{"file0.cpp", "file1.cpp", "file2.cpp"}));
+}
+
+void FileProcessorTest::test_UnrelatedRepositories()
+{
+	if (!test_helpers::hasGit()) {
+		QSKIP("git is not found.");
+	}
+
+	// Both repositories have 'file0.cpp', so their relative paths would be equal.
+	const auto firstPath = makeRepository("unrelated/first", 1, true);
+	const auto secondPath = makeRepository("unrelated/second", 1, true);
+	QVERIFY(!firstPath.isEmpty() && !secondPath.isEmpty());
+	const auto reportPath = m_dir.filePath("unrelated.jsonl");
+	const auto patchPath = m_dir.filePath("unrelated.patch");
+
+	const QStringList arguments = {"--emit-patch", patchPath, "--report", reportPath};
+	QCOMPARE(test_helpers::runApp(runArguments(arguments, {firstPath, secondPath})),
+	         static_cast<int>(apperror::Success));
+
+	auto records = test_helpers::readReport(reportPath);
+	QVERIFY(!records.empty());
+	records.pop_back();
+	QStringList paths;
+	for (const auto &record : records) {
+		paths.append(record.value(cPath).toString());
+	}
+	paths.sort();
+	QCOMPARE(paths, (QStringList{"first/file0.cpp", "second/file0.cpp"}));
+
+	// Diffs of both files are in the patch.
+	const auto patch = test_helpers::readFile(patchPath);
+	QVERIFY(patch.contains("a/first/file0.cpp"));
+	QVERIFY(patch.contains("a/second/file0.cpp"));
+}
+
+QTEST_GUILESS_MAIN(FileProcessorTest)
+
+#include "tst_FileProcessorTest.moc"
@@ -0,0 +1,265 @@
+#include <QtTest>
+
+#include <QTemporaryDir>
+
+#include "../src/file_processor/git/CommitWriter.h"
+#include "../src/file_processor/git/IndexWriter.h"
+#include "../src/file_processor/git/RepoResolver.h"
+#include "../src/file_processor/git/git_helpers.h"
+#include "../src/file_processor/parser/header_helpers.h"
+#include "../src/logger/log.h"
+#include "test_helpers.h"
+
+namespace {
+
+const QByteArray cHashA(40, 'a');
+const QByteArray cHashB(40, 'b');
+const QByteArray cHashC(40, 'c');
+
+QByteArray makeBlameLine(const QByteArray &hash, const QByteArray &author, int line)
+{
+	return hash + " main.cpp (" + author + " 2020-01-01 00:00:00 +0000 "
+	    + QByteArray::number(line) + ") int value;\n";
+}
+
+// Lines of two authors, one of whom has two commits, and one uncommitted line.
+GitBlame makeBlame()
+{
+	return git_helpers::parseBlame(makeBlameLine(cHashA, "Bill Gates", 1)
+	                               + makeBlameLine(cHashA, "Bill Gates", 2)
+	                               + makeBlameLine(cHashB, "Steve Jobs", 3)
+	                               + makeBlameLine(cHashA, "Bill Gates", 4)
+	                               + makeBlameLine(cHashC, "Bill Gates", 5)
+	                               + makeBlameLine(QByteArray(GitBlame::cUncommittedHash.data()),
+	                                               "Not Committed", 6));
+}
+
+// Returns the id of a new blob, that has 'content', or an empty string, if it is not written.
+QString writeBlob(const QString &repoPath, const QByteArray &content)
+{
+	const auto output = test_helpers::runGit({"hash-object", "-w", "--stdin"}, repoPath, content);
+	return output ? QString(output->trimmed()) : QString();
+}
+
+QByteArray gitOutput(const QStringList &arguments, const QString &repoPath)
+{
+	return test_helpers::runGit(arguments, repoPath).value_or("<failed>");
+}
+
+}  // namespace
+
+class GitTest : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+	void test_ParseBlame();
+	void test_BlameStatistic();
+	void test_BlameStatisticSkipsCommits();
+	void test_BlameStatisticMergesAliases();
+	void test_BlameRepository();
+	void test_LocateNestedRepositories();
+	void test_CommitBlobs();
+	void test_StageBlobs();
+	void test_StageKeepsUnstagedChanges();
+
+private:
+	// Returns the path of a new repository, that has committed 'main.cpp' with 'content'.
+	QString makeRepository(const QString &name, const QByteArray &content);
+
+private:
+	QTemporaryDir m_dir;
+};
+
+void GitTest::initTestCase()
+{
+	logger::environment::setPattern();
+	QVERIFY(m_dir.isValid());
+}
+
+QString GitTest::makeRepository(const QString &name, const QByteArray &content)
+{
+	const auto repoPath = m_dir.filePath(name);
+	const bool isCreated = test_helpers::initRepository(repoPath)
+	    && test_helpers::writeFile(repoPath + "/main.cpp", content)
+	    && test_helpers::commitAll(repoPath);
+	return isCreated ? repoPath : QString();
+}
+
+void GitTest::test_ParseBlame()
+{
+	const auto blame = makeBlame();
+
+	// Every distinct commit and author is stored once, lines refer to them by id.
+	QCOMPARE(blame.commits, (std::vector<QString>{cHashA, cHashB, cHashC,
+	                                              GitBlame::cUncommittedHash}));
+	QCOMPARE(blame.authors,
+	         (std::vector<QString>{"Bill Gates", "Steve Jobs", "Not Committed"}));
+	QCOMPARE(blame.commitAuthors, (std::vector<GitBlame::Id>{0, 1, 0, 2}));
+	QCOMPARE(blame.lines, (std::vector<GitBlame::Id>{0, 0, 1, 0, 2, 3}));
+}
+
+void GitTest::test_BlameStatistic()
+{
+	// The first line is the header, uncommitted lines have no author yet.
+	const auto statistic =
+	    header_helpers::collectGitBlameStatistic(makeBlame(), {}, {0, 1}, AuthorAliasesMap{});
+	QCOMPARE(statistic.size(), std::size_t(2));
+	QCOMPARE(statistic.at("Bill Gates"), 0.75);
+	QCOMPARE(statistic.at("Steve Jobs"), 0.25);
+}
+
+void GitTest::test_BlameStatisticSkipsCommits()
+{
+	const std::set<QString> skipCommits = {cHashB};
+	const auto statistic = header_helpers::collectGitBlameStatistic(makeBlame(), skipCommits,
+	                                                                 {0, 1}, AuthorAliasesMap{});
+	QCOMPARE(statistic.size(), std::size_t(1));
+	QCOMPARE(statistic.at("Bill Gates"), 1.);
+}
+
+void GitTest::test_BlameStatisticMergesAliases()
+{
+	const AuthorAliasesMap aliases = {{"Steve Jobs", "Bill Gates"}};
+	const auto statistic =
+	    header_helpers::collectGitBlameStatistic(makeBlame(), {}, {0, 0}, aliases);
+	QCOMPARE(statistic.size(), std::size_t(1));
+	QCOMPARE(statistic.at("Bill Gates"), 1.);
+}
+
+void GitTest::test_BlameRepository()
+{
+	if (!test_helpers::hasGit()) {
+		QSKIP("git is not found.");
+	}
+
+	const auto repoPath = m_dir.filePath("blame");
+	QVERIFY(test_helpers::initRepository(repoPath));
+	QVERIFY(test_helpers::writeFile(repoPath + "/main.cpp", "int a;\nint b;\n"));
+	QVERIFY(test_helpers::commitAll(repoPath));
+	QVERIFY(test_helpers::writeFile(repoPath + "/main.cpp", "int a;\nint b;\nint c;\n"));
+	QVERIFY(test_helpers::runGit({"-c", "user.name=Steve Jobs", "commit", "-q", "-a", "-m", "C"},
+	                             repoPath));
+
+	const auto blame = git_helpers::blameFile(repoPath, "main.cpp", "HEAD");
+	QCOMPARE(blame.commits.size(), std::size_t(2));
+	QCOMPARE(blame.authors, (std::vector<QString>{"Bill Gates", "Steve Jobs"}));
+	QCOMPARE(blame.lines, (std::vector<GitBlame::Id>{0, 0, 1}));
+}
+
+void GitTest::test_LocateNestedRepositories()
+{
+	// Repositories are found by their '.git' entries, which is a file in submodules.
+	const auto outerPath = m_dir.filePath("outer");
+	const auto nestedPath = outerPath + "/nested";
+	const auto modulePath = outerPath + "/module";
+	QVERIFY(QDir().mkpath(outerPath + "/.git"));
+	QVERIFY(QDir().mkpath(nestedPath + "/.git"));
+	QVERIFY(test_helpers::writeFile(modulePath + "/.git", "gitdir: ../.git/modules/module\n"));
+	QVERIFY(QDir().mkpath(m_dir.filePath("none")));
+
+	RepoResolver resolver;
+	const auto check = [&resolver](const QString &filePath, const QString &repoRoot,
+	                               const QString &relativePath) {
+		const auto location = resolver.locate(filePath);
+		return location.repoRoot == repoRoot && location.relativePath == relativePath;
+	};
+
+	QVERIFY(check(outerPath + "/a.cpp", outerPath, "a.cpp"));
+	QVERIFY(check(outerPath + "/sub/b.cpp", outerPath, "sub/b.cpp"));
+	// Paths stay relative to the outermost working tree.
+	QVERIFY(check(nestedPath + "/c.cpp", nestedPath, "nested/c.cpp"));
+	QVERIFY(check(nestedPath + "/deep/d.cpp", nestedPath, "nested/deep/d.cpp"));
+	QVERIFY(check(modulePath + "/e.cpp", modulePath, "module/e.cpp"));
+	QCOMPARE(resolver.locate(nestedPath + "/c.cpp").topRoot, outerPath);
+	// Roots are cached, so a second lookup gives the same result.
+	QVERIFY(check(nestedPath + "/c.cpp", nestedPath, "nested/c.cpp"));
+	QVERIFY(check(m_dir.filePath("none/f.cpp"), QString(), QString()));
+}
+
+void GitTest::test_CommitBlobs()
+{
+	if (!test_helpers::hasGit()) {
+		QSKIP("git is not found.");
+	}
+
+	const auto repoPath = makeRepository("commit", "int a;\n");
+	QVERIFY(!repoPath.isEmpty());
+	const auto head = gitOutput({"rev-parse", "HEAD"}, repoPath);
+	const auto blobId = writeBlob(repoPath, "int b;\n");
+	QVERIFY(!blobId.isEmpty());
+
+	CommitWriter writer("refs/heads/bot/headers", "HEAD");
+	writer.add(repoPath, "main.cpp", blobId);
+	writer.close();
+
+	// The ref gets a commit on top of the base revision, the branch and the files stay the same.
+	QCOMPARE(gitOutput({"show", "bot/headers:main.cpp"}, repoPath), QByteArray("int b;\n"));
+	QCOMPARE(gitOutput({"rev-parse", "bot/headers^"}, repoPath), head);
+	QCOMPARE(gitOutput({"rev-parse", "HEAD"}, repoPath), head);
+	QCOMPARE(gitOutput({"status", "--porcelain"}, repoPath), QByteArray());
+	QCOMPARE(test_helpers::readFile(repoPath + "/main.cpp"), QByteArray("int a;\n"));
+}
+
+void GitTest::test_StageBlobs()
+{
+	if (!test_helpers::hasGit()) {
+		QSKIP("git is not found.");
+	}
+
+	const auto repoPath = makeRepository("stage", "int a;\n");
+	QVERIFY(!repoPath.isEmpty());
+	QVERIFY(test_helpers::writeFile(repoPath + "/other.cpp", "int c;\n"));
+	QVERIFY(test_helpers::commitAll(repoPath));
+	const auto head = gitOutput({"rev-parse", "HEAD"}, repoPath);
+	const auto blobId = writeBlob(repoPath, "int b;\n");
+	const auto otherBlobId = writeBlob(repoPath, "int d;\n");
+	QVERIFY(!blobId.isEmpty() && !otherBlobId.isEmpty());
+
+	// The file without new content has unstaged changes, so only its staged blob is replaced.
+	IndexWriter writer;
+	writer.add(repoPath, "main.cpp", blobId, "int b;\n");
+	writer.add(repoPath, "other.cpp", otherBlobId, {});
+	writer.close();
+
+	QCOMPARE(gitOutput({"show", ":main.cpp"}, repoPath), QByteArray("int b;\n"));
+	QCOMPARE(gitOutput({"show", ":other.cpp"}, repoPath), QByteArray("int d;\n"));
+	QCOMPARE(test_helpers::readFile(repoPath + "/main.cpp"), QByteArray("int b;\n"));
+	QCOMPARE(test_helpers::readFile(repoPath + "/other.cpp"), QByteArray("int c;\n"));
+	QCOMPARE(gitOutput({"rev-parse", "HEAD"}, repoPath), head);
+}
+
+void GitTest::test_StageKeepsUnstagedChanges()
+{
+	if (!test_helpers::hasGit()) {
+		QSKIP("git is not found.");
+	}
+
+	const auto repoPath = makeRepository("unstaged", "int a;\n");
+	QVERIFY(!repoPath.isEmpty());
+	QVERIFY(test_helpers::writeFile(repoPath + "/changed.cpp", "int c;\n"));
+	QVERIFY(test_helpers::commitAll(repoPath));
+
+	// Line endings differ only in the working tree, so the file has no unstaged changes for git.
+	QVERIFY(test_helpers::runGit({"config", "core.autocrlf", "true"}, repoPath));
+	QVERIFY(test_helpers::writeFile(repoPath + "/main.cpp", "int a;\r\n"));
+	QVERIFY(test_helpers::writeFile(repoPath + "/changed.cpp", "int c;\nint d;\n"));
+
+	const auto blobId = writeBlob(repoPath, "int b;\n");
+	const auto changedBlobId = writeBlob(repoPath, "int e;\n");
+	QVERIFY(!blobId.isEmpty() && !changedBlobId.isEmpty());
+
+	IndexWriter writer;
+	writer.add(repoPath, "main.cpp", blobId, "int b;\n");
+	writer.add(repoPath, "changed.cpp", changedBlobId, "int e;\n");
+	writer.close();
+
+	QCOMPARE(gitOutput({"show", ":changed.cpp"}, repoPath), QByteArray("int e;\n"));
+	QCOMPARE(test_helpers::readFile(repoPath + "/main.cpp"), QByteArray("int b;\n"));
+	QCOMPARE(test_helpers::readFile(repoPath + "/changed.cpp"), QByteArray("int c;\nint d;\n"));
+}
+
+QTEST_GUILESS_MAIN(GitTest)
+
+#include "tst_GitTest.moc"
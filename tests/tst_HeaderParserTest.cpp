@@ -0,0 +1,271 @@
+#include <QtTest>
+
+#include <string>
+
+#include "../src/file_processor/parser/Header.h"
+#include "../src/file_processor/parser/byte_search.h"
+#include "../src/file_processor/parser/header_helpers.h"
+#include "../src/file_processor/parser/header_utils.h"
+#include "../src/file_utils/file_utils.h"
+#include "../src/logger/log.h"
+#include "test_helpers.h"
+
+namespace {
+
+using byte_search::Isa;
+
+constexpr auto npos = std::string_view::npos;
+
+std::vector<Isa> supportedIsas()
+{
+	std::vector<Isa> isas;
+	for (const auto isa : {Isa::Scalar, Isa::Sse2, Isa::Avx2}) {
+		if (byte_search::isSupported(isa)) {
+			isas.push_back(isa);
+		}
+	}
+	return isas;
+}
+
+QByteArray isaName(Isa isa)
+{
+	switch (isa) {
+	case Isa::Scalar: return "Scalar";
+	case Isa::Sse2: return "SSE2";
+	case Isa::Avx2: return "AVX2";
+	}
+	return {};
+}
+
+std::string withNeedleAt(std::size_t size, std::string_view needle, std::size_t pos)
+{
+	std::string haystack(size, 'a');
+	haystack.replace(pos, needle.size(), needle);
+	return haystack;
+}
+
+// Field tokenizer is constexpr, so its cases are checked at compile time.
+constexpr bool isField(std::string_view line, header_fields::FieldType type, std::string_view value)
+{
+	const auto token = header_helpers::tokenizeField(line, "**");
+	return token && token->type == type && token->value == value;
+}
+
+static_assert(isField("** File      main.cpp", header_fields::FieldType::File, "main.cpp"));
+static_assert(isField("** Author    Bill Gates", header_fields::FieldType::Author, "Bill Gates"));
+static_assert(isField("** This file is part of Core", header_fields::FieldType::Component, "Core"));
+static_assert(isField("** File ", header_fields::FieldType::File, ""));
+static_assert(isField("**", header_fields::FieldType::Default, ""));
+static_assert(!header_helpers::tokenizeField("**File main.cpp", "**"));
+static_assert(!header_helpers::tokenizeField("** Files main.cpp", "**"));
+static_assert(!header_helpers::tokenizeField("** File", "**"));
+static_assert(!header_helpers::tokenizeField("// File main.cpp", "**"));
+static_assert(!header_helpers::tokenizeField("** Unknown field", "**"));
+
+}  // namespace
+
+class HeaderParserTest : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+	void test_FindAtBlockBoundary();
+	void test_FindInTail();
+	void test_FindWholeHaystack();
+	void test_FindNearMiss();
+	void test_Count();
+	void test_HeaderRangeCrossingOffset();
+	void test_SerializeWithoutFields();
+	void test_StreamedHeaderCut();
+
+private:
+	QTemporaryDir m_dir;
+	QString m_staticConfigPath;
+};
+
+void HeaderParserTest::initTestCase()
+{
+	logger::environment::setPattern();
+	QVERIFY(m_dir.isValid());
+	m_staticConfigPath = test_helpers::writeStaticConfig(m_dir.path());
+}
+
+void HeaderParserTest::test_FindAtBlockBoundary()
+{
+	constexpr std::string_view needle = "xyz";
+
+	for (const auto isa : supportedIsas()) {
+		// Needle starts in one 16 or 32 byte block and ends in the next one.
+		for (const std::size_t pos : {14, 15, 30, 31, 46, 47, 62, 63}) {
+			const auto haystack = withNeedleAt(100, needle, pos);
+			QVERIFY2(byte_search::find(haystack, needle, isa) == pos,
+			         isaName(isa) + " at " + QByteArray::number(pos));
+		}
+	}
+}
+
+void HeaderParserTest::test_FindInTail()
+{
+	constexpr std::string_view needle = "xyz";
+
+	for (const auto isa : supportedIsas()) {
+		// Bytes after the last full block (and before it, up to the needle size) are searched
+		// without SIMD.
+		for (std::size_t size = needle.size(); size <= 80; size++) {
+			const auto pos = size - needle.size();
+			const auto haystack = withNeedleAt(size, needle, pos);
+			QVERIFY2(byte_search::find(haystack, needle, isa) == pos,
+			         isaName(isa) + " in " + QByteArray::number(size) + " bytes");
+		}
+	}
+}
+
+void HeaderParserTest::test_FindWholeHaystack()
+{
+	for (const auto isa : supportedIsas()) {
+		for (const std::size_t size : {2, 15, 16, 17, 31, 32, 33, 64}) {
+			std::string needle(size, 'a');
+			needle.front() = 'x';
+			needle.back() = 'z';
+			QVERIFY2(byte_search::find(needle, needle, isa) == 0,
+			         isaName(isa) + " of " + QByteArray::number(size) + " bytes");
+		}
+	}
+}
+
+void HeaderParserTest::test_FindNearMiss()
+{
+	for (const auto isa : supportedIsas()) {
+		// First and last bytes match at every block, but the middle one does not.
+		std::string haystack;
+		while (haystack.size() < 100) {
+			haystack += "xaz";
+		}
+		QVERIFY2(byte_search::find(haystack, "xyz", isa) == npos, isaName(isa));
+
+		haystack += "xyz";
+		QVERIFY2(byte_search::find(haystack, "xyz", isa) == haystack.size() - 3, isaName(isa));
+	}
+}
+
+void HeaderParserTest::test_Count()
+{
+	for (const auto isa : supportedIsas()) {
+		for (std::size_t size = 0; size <= 100; size++) {
+			std::string haystack(size, 'a');
+			for (std::size_t i = 0; i < size; i += 3) {
+				haystack[i] = '\n';
+			}
+			QVERIFY2(byte_search::count(haystack, '\n', isa) == (size + 2) / 3,
+			         isaName(isa) + " in " + QByteArray::number(size) + " bytes");
+		}
+
+		// More matches than an 8-bit lane counter holds between flushes.
+		const std::string newlines(300 * 32 + 7, '\n');
+		QVERIFY2(byte_search::count(newlines, '\n', isa) == newlines.size(), isaName(isa));
+	}
+}
+
+void HeaderParserTest::test_HeaderRangeCrossingOffset()
+{
+	constexpr std::string_view prefix = "/*\n";
+	constexpr std::string_view suffix = "\n*/\n";
+	constexpr std::string_view header = "/*\n** Author Bill Gates\n*/\n";
+	constexpr std::size_t maxHeaderOffset = 16;
+
+	const auto findHeader = [&](std::size_t headerPos) -> std::optional<std::string> {
+		const auto content = std::string(headerPos, '\n').append(header).append("int main();\n");
+		const auto range = header_helpers::headerRange(content, prefix, suffix, maxHeaderOffset);
+		if (!range.has_value()) {
+			return std::nullopt;
+		}
+		return std::string(header_helpers::getHeader(content, range.value()));
+	};
+
+	// Header ends after the offset.
+	QVERIFY(findHeader(0) == header);
+	QVERIFY(findHeader(maxHeaderOffset - prefix.size()) == header);
+
+	// Only the beginning of the prefix is within the offset.
+	QVERIFY(findHeader(maxHeaderOffset - 1) == header);
+
+	QVERIFY(!findHeader(maxHeaderOffset).has_value());
+}
+
+void HeaderParserTest::test_SerializeWithoutFields()
+{
+	const auto serialize = [](const QString &targetPath) {
+		// Empty component name deletes the only field.
+		const QStringList args = {QCoreApplication::applicationFilePath(), "--component", "",
+		                          targetPath};
+		const Context ctx{targetPath, "/not/used/for/test", RunConfig(args)};
+		const QByteArray content = "int main();\n";
+
+		Header header(ctx, content, GitRepository(ctx.targetRepoRootPath));
+		header.load();
+		header.fixFields();
+
+		return std::pair{header.serialize().toStdString(), header.serializedSize()};
+	};
+
+	{
+		// Empty prefix has no last byte to share with the suffix.
+		const auto suffix = header_utils::suffixMap["cmake"];
+		QCOMPARE(header_utils::prefixMap["cmake"].size(), std::size_t{0});
+		const auto [header, size] = serialize("/not/used/for/test/module.cmake");
+		QVERIFY(header == suffix);
+		QCOMPARE(size, header.size());
+	}
+
+	{
+		const auto prefix = header_utils::prefixMap["cpp"];
+		const auto suffix = header_utils::suffixMap["cpp"];
+		const auto [header, size] = serialize("/not/used/for/test/main.cpp");
+		QVERIFY(header == std::string(prefix).append(suffix.substr(1)));
+		QCOMPARE(size, header.size());
+
+		const auto range = header_helpers::headerRange(header, prefix, suffix);
+		QVERIFY(range.has_value());
+		QVERIFY(header_helpers::getHeader(header, range.value()) == header);
+	}
+}
+
+void HeaderParserTest::test_StreamedHeaderCut()
+{
+	if (!test_helpers::hasGit()) {
+		QSKIP("git is not found.");
+	}
+
+	const auto repoPath = m_dir.filePath("streamed");
+	QVERIFY(test_helpers::initRepository(repoPath));
+
+	// Header starts within the offset, but ends after the head, that is read from a streamed file.
+	constexpr int maxHeaderOffset = 16;
+	QByteArray header(header_utils::prefixMap["cpp"].data());
+	while (header.size() <= maxHeaderOffset + appconst::cMaxStreamedHeaderSize) {
+		header += "** Long header line\n";
+	}
+	header += header_utils::suffixMap["cpp"].data();
+	const QByteArray head = "\n" + header + "int main();\n";
+
+	const auto filePath = repoPath + "/main.cpp";
+	QVERIFY(test_helpers::writeFile(filePath, head));
+	{
+		QFile file(filePath);
+		QVERIFY(file.resize(appconst::cStreamingFileSize));
+	}
+
+	const int exitCode = test_helpers::runApp({"--update-copyright", "--static-config",
+	                                           m_staticConfigPath, "--max-header-offset",
+	                                           QString::number(maxHeaderOffset), filePath});
+	QCOMPARE(exitCode, static_cast<int>(apperror::Success));
+
+	// New header would be written in front of the old one.
+	QCOMPARE(QFileInfo(filePath).size(), appconst::cStreamingFileSize);
+	QCOMPARE(file_utils::readFileHead(filePath, head.size()), head);
+}
+
+QTEST_GUILESS_MAIN(HeaderParserTest)
+
+#include "tst_HeaderParserTest.moc"
@@ -0,0 +1,188 @@
+#include <QtTest>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../src/logger/LogWriter.h"
+
+namespace {
+
+// Collects batches of a writer and holds the writer thread in the sink, until it is released, so
+// rings of producers fill up.
+class Sink
+{
+public:
+	LogWriter::Sink function()
+	{
+		return [this](const QByteArray &batch) {
+			m_isEntered = true;
+			m_isEntered.notify_all();
+			m_isReleased.wait(false);
+			const std::lock_guard lock(m_mutex);
+			m_output += batch;
+		};
+	}
+
+	void hold() { m_isReleased = false; }
+
+	void waitEntered() const { m_isEntered.wait(false); }
+
+	void release()
+	{
+		m_isReleased = true;
+		m_isReleased.notify_all();
+	}
+
+	// Messages without time, that the writer prepends.
+	QList<QByteArray> messages() const
+	{
+		const std::lock_guard lock(m_mutex);
+		QList<QByteArray> result;
+		for (const auto &line : m_output.split('\n')) {
+			if (!line.isEmpty()) {
+				result.append(line.mid(line.indexOf(' ') + 1));
+			}
+		}
+		return result;
+	}
+
+private:
+	mutable std::mutex m_mutex;
+	QByteArray m_output;
+	std::atomic_bool m_isEntered = false;
+	std::atomic_bool m_isReleased = true;
+};
+
+// Is the capacity of a per-thread ring of LogWriter.
+constexpr int cRingCapacity = 1024;
+
+QString message(int thread, int index)
+{
+	return QString("%1 %2").arg(thread).arg(index);
+}
+
+}  // namespace
+
+class LogWriterTest : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void test_DrainOnShutdown();
+	void test_BlockOnOverflow();
+	void test_DropOnOverflow();
+	void test_PerThreadOrder();
+};
+
+void LogWriterTest::test_DrainOnShutdown()
+{
+	Sink sink;
+	{
+		LogWriter writer(LogWriter::OverflowPolicy::Block, sink.function());
+		for (int i = 0; i < 100; ++i) {
+			writer.write(message(0, i));
+		}
+	}
+
+	const auto messages = sink.messages();
+	QCOMPARE(messages.size(), 100);
+	QCOMPARE(messages.back(), message(0, 99).toLocal8Bit());
+}
+
+void LogWriterTest::test_BlockOnOverflow()
+{
+	constexpr int cCount = cRingCapacity * 2;
+	Sink sink;
+	sink.hold();
+	std::atomic_bool isDone = false;
+	{
+		LogWriter writer(LogWriter::OverflowPolicy::Block, sink.function());
+		std::thread producer([&] {
+			for (int i = 0; i < cCount; ++i) {
+				writer.write(message(0, i));
+			}
+			isDone = true;
+		});
+
+		// Writer thread waits in the sink, so the ring of the producer can not take all messages.
+		sink.waitEntered();
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		const bool isBlocked = !isDone;
+
+		sink.release();
+		producer.join();
+		QVERIFY(isBlocked);
+	}
+
+	const auto messages = sink.messages();
+	QCOMPARE(messages.size(), cCount);
+	for (int i = 0; i < cCount; ++i) {
+		QCOMPARE(messages[i], message(0, i).toLocal8Bit());
+	}
+}
+
+void LogWriterTest::test_DropOnOverflow()
+{
+	constexpr int cDroppedCount = 10;
+	Sink sink;
+	sink.hold();
+	{
+		LogWriter writer(LogWriter::OverflowPolicy::Drop, sink.function());
+		writer.write(message(0, 0));
+		sink.waitEntered();
+
+		// The first message is taken from the ring, so the ring is empty again.
+		for (int i = 1; i <= cRingCapacity + cDroppedCount; ++i) {
+			writer.write(message(0, i));
+		}
+		sink.release();
+	}
+
+	const auto messages = sink.messages();
+	QCOMPARE(messages.size(), 1 + cRingCapacity + 1);
+	for (int i = 0; i <= cRingCapacity; ++i) {
+		QCOMPARE(messages[i], message(0, i).toLocal8Bit());
+	}
+	QVERIFY2(messages.back().contains(QString("Dropped %1 ").arg(cDroppedCount).toLocal8Bit()),
+	         messages.back().constData());
+}
+
+void LogWriterTest::test_PerThreadOrder()
+{
+	constexpr int cThreadCount = 4;
+	constexpr int cCount = 5000;
+	Sink sink;
+	{
+		LogWriter writer(LogWriter::OverflowPolicy::Block, sink.function());
+		std::vector<std::thread> producers;
+		for (int thread = 0; thread < cThreadCount; ++thread) {
+			producers.emplace_back([&writer, thread] {
+				for (int i = 0; i < cCount; ++i) {
+					writer.write(message(thread, i));
+				}
+			});
+		}
+		for (auto &producer : producers) {
+			producer.join();
+		}
+	}
+
+	// Messages of different threads interleave, but each thread's messages keep their order.
+	std::vector<int> nextIndexes(cThreadCount, 0);
+	for (const auto &line : sink.messages()) {
+		const auto fields = line.split(' ');
+		QCOMPARE(fields.size(), 2);
+		const int thread = fields[0].toInt();
+		QCOMPARE(fields[1].toInt(), nextIndexes[thread]);
+		++nextIndexes[thread];
+	}
+	for (const int nextIndex : nextIndexes) {
+		QCOMPARE(nextIndex, cCount);
+	}
+}
+
+QTEST_GUILESS_MAIN(LogWriterTest)
+
+#include "tst_LogWriterTest.moc"
@@ -0,0 +1,120 @@
+#include <QtTest>
+
+#include <QProcess>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+
+#include "../src/file_processor/patch/patch_helpers.h"
+#include "../src/file_utils/file_utils.h"
+#include "../src/logger/log.h"
+
+namespace {
+
+const QByteArray cFileHeader = "diff --git a/main.cpp b/main.cpp\n"
+                               "--- a/main.cpp\n"
+                               "+++ b/main.cpp\n";
+
+void writeRawFile(const QString &path, const QByteArray &content)
+{
+	QFile file(path);
+	QVERIFY(file.open(QIODevice::WriteOnly));
+	QCOMPARE(file.write(content), content.size());
+}
+
+}  // namespace
+
+class PatchTest : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+	void test_HunkWithContext();
+	void test_InsertAtStart();
+	void test_NoNewlineAtEnd();
+	void test_Unchanged();
+	void test_ApplyToCrLfFile();
+};
+
+void PatchTest::initTestCase()
+{
+	logger::environment::setPattern();
+}
+
+void PatchTest::test_HunkWithContext()
+{
+	const QByteArray content = "A\nB\nC\nD\nE\nF\nG\n";
+	const auto diff = patch_helpers::makeFileDiff("main.cpp", content, 2, "X\n", true);
+
+	// Only three lines after the change are context, the rest of the file is not in the hunk.
+	QCOMPARE(diff, cFileHeader
+	                   + "@@ -1,4 +1,4 @@\n"
+	                     "-A\n"
+	                     "+X\n"
+	                     " B\n"
+	                     " C\n"
+	                     " D\n");
+}
+
+void PatchTest::test_InsertAtStart()
+{
+	const QByteArray content = "int main();\n";
+	const auto diff = patch_helpers::makeFileDiff("main.cpp", content, 0, "// X\n", true);
+
+	QCOMPARE(diff, cFileHeader
+	                   + "@@ -1 +1,2 @@\n"
+	                     "+// X\n"
+	                     " int main();\n");
+}
+
+void PatchTest::test_NoNewlineAtEnd()
+{
+	const auto diff = patch_helpers::makeFileDiff("main.cpp", "A", 1, "B", true);
+
+	QCOMPARE(diff, cFileHeader
+	                   + "@@ -1 +1 @@\n"
+	                     "-A\n"
+	                     "\\ No newline at end of file\n"
+	                     "+B\n"
+	                     "\\ No newline at end of file\n");
+}
+
+void PatchTest::test_Unchanged()
+{
+	const QByteArray content = "A\nB\n";
+	QVERIFY(patch_helpers::makeFileDiff("main.cpp", content, 2, "A\n", true).isEmpty());
+}
+
+void PatchTest::test_ApplyToCrLfFile()
+{
+	const auto git = QStandardPaths::findExecutable("git");
+	if (git.isEmpty()) {
+		QSKIP("git is not found.");
+	}
+
+	const QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const auto filePath = dir.filePath("main.cpp");
+	writeRawFile(filePath, "A\r\nB\r\nC\r\n");
+
+	// Content is read like a file, that is not streamed, so carriage returns are dropped.
+	const auto content = file_utils::readFile(filePath);
+	QCOMPARE(content, QByteArray("A\nB\nC\n"));
+	QVERIFY(file_utils::hasCrLfLineEnds(filePath));
+
+	const auto diff = patch_helpers::makeFileDiff("main.cpp", content, 2, "X\n", true, "\r\n");
+	const auto patchPath = dir.filePath("headers.patch");
+	writeRawFile(patchPath, diff);
+
+	QProcess process;
+	process.setWorkingDirectory(dir.path());
+	process.start(git, {"apply", patchPath});
+	QVERIFY(process.waitForFinished());
+	QVERIFY2(process.exitCode() == 0, process.readAllStandardError());
+
+	QCOMPARE(file_utils::readFileTail(filePath, 0), QByteArray("X\r\nB\r\nC\r\n"));
+}
+
+QTEST_GUILESS_MAIN(PatchTest)
+
+#include "tst_PatchTest.moc"
@@ -1,10 +1,40 @@
 #include <QtTest>
 
 #include <QStringList>
+#include <QTemporaryDir>
+#include <functional>
 
 #include "../src/configuration/RunConfig.h"
 #include "../src/logger/log.h"
 
+Q_DECLARE_METATYPE(RunOptions)
+
+namespace {
+
+// Returns the value of the config, that is named like its getter.
+QVariant configValue(const RunConfig &config, const QString &name)
+{
+	using Getter = std::function<QVariant(const RunConfig &)>;
+	// clang-format off
+	static const QHash<QString, Getter> getters = {
+	    {"shardIndex", [](const RunConfig &c) { return c.shardIndex(); }},
+	    {"shardCount", [](const RunConfig &c) { return c.shardCount(); }},
+	    {"shardCostsPath", [](const RunConfig &c) { return c.shardCostsPath(); }},
+	    {"reportPath", [](const RunConfig &c) { return c.reportPath(); }},
+	    {"maxHeaderOffset", [](const RunConfig &c) { return c.maxHeaderOffset(); }},
+	    {"jobs", [](const RunConfig &c) { return c.jobs(); }},
+	    {"gitJobs", [](const RunConfig &c) { return c.gitJobs(); }},
+	    {"tracePath", [](const RunConfig &c) { return c.tracePath(); }},
+	    {"patchPath", [](const RunConfig &c) { return c.patchPath(); }},
+	    {"commitRef", [](const RunConfig &c) { return c.commitRef(); }},
+	    {"revision", [](const RunConfig &c) { return c.revision(); }}
+	};
+	// clang-format on
+	return getters.value(name)(config);
+}
+
+}  // namespace
+
 class RunConfigTest : public QObject
 {
 	Q_OBJECT
@@ -14,6 +44,11 @@ private slots:
 	void test_AllArguments();
 	void test_ReadOnlyMode();
 	void test_MaxBlameAuthors();
+	void test_Options_data();
+	void test_Options();
+
+private:
+	QTemporaryDir m_dir;
 };
 
 void RunConfigTest::initTestCase()
@@ -131,6 +166,113 @@ void RunConfigTest::test_MaxBlameAuthors()
 	}
 }
 
+void RunConfigTest::test_Options_data()
+{
+	using appconst::cMaxHeaderOffset;
+
+	QTest::addColumn<QStringList>("arguments");
+	QTest::addColumn<RunOptions>("setOptions");
+	QTest::addColumn<RunOptions>("unsetOptions");
+	QTest::addColumn<QVariantHash>("values");
+
+	const auto optionalModes = RunOptions(RunOption::CheckMode) | RunOption::CheckAllMode
+	    | RunOption::MergeShardReports | RunOption::DropLogsOnOverflow | RunOption::Profile
+	    | RunOption::AdaptiveGitJobs | RunOption::RevisionMode | RunOption::StagedMode
+	    | RunOption::ReadOnlyMode;
+	const auto patchPath = m_dir.path() + "/headers.patch";
+
+	// clang-format off
+	QTest::newRow("defaults") << QStringList{} << RunOptions{} << optionalModes << QVariantHash{
+	    {"shardIndex", 0}, {"shardCount", 1}, {"shardCostsPath", ""}, {"reportPath", ""},
+	    {"maxHeaderOffset", cMaxHeaderOffset}, {"jobs", QThread::idealThreadCount()},
+	    {"gitJobs", 0}, {"tracePath", ""}, {"patchPath", ""}, {"commitRef", ""},
+	    {"revision", "HEAD"}};
+	QTest::newRow("check")
+	    << QStringList{"--check"}
+	    << (RunOptions(RunOption::CheckMode) | RunOption::ReadOnlyMode)
+	    << RunOptions(RunOption::CheckAllMode) << QVariantHash{};
+	QTest::newRow("check-all")
+	    << QStringList{"--check-all"}
+	    << (RunOptions(RunOption::CheckMode) | RunOption::CheckAllMode | RunOption::ReadOnlyMode)
+	    << RunOptions{} << QVariantHash{};
+	QTest::newRow("shard")
+	    << QStringList{"--shard", "2/4", "--shard-costs", "/not/existed/costs.jsonl",
+	                   "--report", "/not/existed/report.jsonl"}
+	    << RunOptions{} << RunOptions(RunOption::MergeShardReports) << QVariantHash{
+	    {"shardIndex", 1}, {"shardCount", 4}, {"shardCostsPath", "/not/existed/costs.jsonl"},
+	    {"reportPath", "/not/existed/report.jsonl"}};
+	QTest::newRow("merge-shard-reports")
+	    << QStringList{"--merge-shard-reports"} << RunOptions(RunOption::MergeShardReports)
+	    << RunOptions{} << QVariantHash{};
+	QTest::newRow("unlimited header offset")
+	    << QStringList{"--max-header-offset=0"} << RunOptions{} << RunOptions{}
+	    << QVariantHash{{"maxHeaderOffset", 0}};
+	QTest::newRow("header offset")
+	    << QStringList{"--max-header-offset=1024"} << RunOptions{} << RunOptions{}
+	    << QVariantHash{{"maxHeaderOffset", 1024}};
+	QTest::newRow("drop-logs")
+	    << QStringList{"--drop-logs"} << RunOptions(RunOption::DropLogsOnOverflow)
+	    << RunOptions{} << QVariantHash{};
+	QTest::newRow("profile")
+	    << QStringList{"--profile"} << RunOptions(RunOption::Profile) << RunOptions{}
+	    << QVariantHash{};
+	QTest::newRow("trace")
+	    << QStringList{"--trace", "/not/existed/trace.json"} << RunOptions{} << RunOptions{}
+	    << QVariantHash{{"tracePath", "/not/existed/trace.json"}};
+	QTest::newRow("jobs")
+	    << QStringList{"--jobs", "3", "--git-jobs", "5"} << RunOptions{}
+	    << RunOptions(RunOption::AdaptiveGitJobs) << QVariantHash{{"jobs", 3}, {"gitJobs", 5}};
+	QTest::newRow("adaptive git jobs")
+	    << QStringList{"--jobs=2", "--git-jobs=auto"} << RunOptions(RunOption::AdaptiveGitJobs)
+	    << RunOptions{} << QVariantHash{{"jobs", 2}, {"gitJobs", 0}};
+	QTest::newRow("emit-patch")
+	    << QStringList{"--emit-patch", m_dir.path() + "/not/existed/../headers.patch"}
+	    << RunOptions(RunOption::ReadOnlyMode) << RunOptions{}
+	    << QVariantHash{{"patchPath", patchPath}};
+	QTest::newRow("commit-to branch")
+	    << QStringList{"--commit-to", "bot/headers"} << RunOptions{}
+	    << RunOptions(RunOption::ReadOnlyMode)
+	    << QVariantHash{{"commitRef", "refs/heads/bot/headers"}};
+	QTest::newRow("commit-to ref")
+	    << QStringList{"--commit-to=refs/notes/headers"} << RunOptions{} << RunOptions{}
+	    << QVariantHash{{"commitRef", "refs/notes/headers"}};
+	QTest::newRow("rev")
+	    << QStringList{"--rev", "v1.0"}
+	    << (RunOptions(RunOption::RevisionMode) | RunOption::ReadOnlyMode)
+	    << RunOptions{} << QVariantHash{{"revision", "v1.0"}};
+	QTest::newRow("rev with commit-to")
+	    << QStringList{"--rev", "v1.0", "--commit-to", "bot/headers"}
+	    << RunOptions(RunOption::RevisionMode) << RunOptions(RunOption::ReadOnlyMode)
+	    << QVariantHash{};
+	QTest::newRow("staged")
+	    << QStringList{"--staged"} << RunOptions(RunOption::StagedMode)
+	    << RunOptions(RunOption::ReadOnlyMode) << QVariantHash{{"revision", "HEAD"}};
+	QTest::newRow("staged check")
+	    << QStringList{"--staged", "--check"}
+	    << (RunOptions(RunOption::StagedMode) | RunOption::CheckMode)
+	    << RunOptions{} << QVariantHash{};
+	// clang-format on
+}
+
+void RunConfigTest::test_Options()
+{
+	QFETCH(QStringList, arguments);
+	QFETCH(RunOptions, setOptions);
+	QFETCH(RunOptions, unsetOptions);
+	QFETCH(QVariantHash, values);
+
+	qputenv("LINT_ENABLE_COPYRIGHT_UPDATE", "");
+	arguments.prepend(QCoreApplication::applicationFilePath());
+	arguments.append("/not/used/for/test");
+	const RunConfig runConfig(arguments);
+
+	QCOMPARE(static_cast<int>(runConfig.options() & setOptions), static_cast<int>(setOptions));
+	QCOMPARE(static_cast<int>(runConfig.options() & unsetOptions), 0);
+	for (auto it = values.cbegin(); it != values.cend(); ++it) {
+		QVERIFY2(configValue(runConfig, it.key()) == it.value(), qPrintable(it.key()));
+	}
+}
+
 QTEST_GUILESS_MAIN(RunConfigTest)
 
 #include "tst_RunConfigTest.moc"
\ No newline at end of file
@@ -0,0 +1,263 @@
+#include <QtTest>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTemporaryDir>
+#include <set>
+
+#include "../src/constants.h"
+#include "../src/file_processor/report/ReportWriter.h"
+#include "../src/file_processor/report/report_helpers.h"
+#include "../src/file_processor/shard/shard_helpers.h"
+#include "../src/logger/log.h"
+#include "test_helpers.h"
+
+namespace {
+
+using namespace appconst::json::report;
+
+std::vector<QString> makePaths(int count)
+{
+	std::vector<QString> paths;
+	for (int i = 0; i < count; i++) {
+		paths.emplace_back(QString("src/file%1.cpp").arg(i));
+	}
+	return paths;
+}
+
+// Returns paths of the shard instead of their indexes, so shards of different inputs are
+// comparable.
+std::set<QString> selectPaths(const std::vector<QString> &paths, int shardIndex, int shardCount,
+                              const shard_helpers::FileCosts &costs)
+{
+	std::set<QString> result;
+	for (const auto index : shard_helpers::selectShard(paths, shardIndex, shardCount, costs)) {
+		result.insert(paths[index]);
+	}
+	return result;
+}
+
+QJsonObject makeFileRecord(const QString &path, const QString &action, double durationMs)
+{
+	return {{cPath, path}, {cAction, action}, {cDurationMs, durationMs}};
+}
+
+bool writeReport(const QString &path, const std::vector<QJsonObject> &records)
+{
+	QByteArray content;
+	for (const auto &record : records) {
+		content += QJsonDocument(record).toJson(QJsonDocument::Compact) + '\n';
+	}
+	return test_helpers::writeFile(path, content);
+}
+
+}  // namespace
+
+class ShardTest : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+	void test_HashShardsPartitionFiles();
+	void test_ShardsDoNotDependOnOrder();
+	void test_CostShardsAreBalanced();
+	void test_ReadFileCosts();
+	void test_MergeReports();
+	void test_MergeReportsOfDifferentRuns();
+	void test_MergeDuplicateShard();
+	void test_MergeMissingShard();
+	void test_MergeIncompleteReport();
+	void test_WriteReport();
+	void test_UnclosedReportIsIncomplete();
+
+private:
+	QTemporaryDir m_dir;
+};
+
+void ShardTest::initTestCase()
+{
+	logger::environment::setPattern();
+	QVERIFY(m_dir.isValid());
+}
+
+void ShardTest::test_HashShardsPartitionFiles()
+{
+	constexpr int cShardCount = 4;
+	const auto paths = makePaths(100);
+
+	std::set<QString> allPaths;
+	std::size_t totalSize = 0;
+	for (int shard = 0; shard < cShardCount; shard++) {
+		const auto shardPaths = selectPaths(paths, shard, cShardCount, {});
+		QVERIFY(!shardPaths.empty());
+		allPaths.insert(shardPaths.cbegin(), shardPaths.cend());
+		totalSize += shardPaths.size();
+	}
+
+	// Every file belongs to exactly one shard.
+	QCOMPARE(totalSize, paths.size());
+	QCOMPARE(allPaths.size(), paths.size());
+}
+
+void ShardTest::test_ShardsDoNotDependOnOrder()
+{
+	constexpr int cShardCount = 3;
+	const auto paths = makePaths(50);
+	const std::vector<QString> reversedPaths(paths.crbegin(), paths.crend());
+
+	shard_helpers::FileCosts costs;
+	for (std::size_t i = 0; i < paths.size(); i += 2) {
+		costs[paths[i]] = static_cast<double>(i % 7);
+	}
+
+	for (int shard = 0; shard < cShardCount; shard++) {
+		QCOMPARE(selectPaths(reversedPaths, shard, cShardCount, {}),
+		         selectPaths(paths, shard, cShardCount, {}));
+		QCOMPARE(selectPaths(reversedPaths, shard, cShardCount, costs),
+		         selectPaths(paths, shard, cShardCount, costs));
+	}
+}
+
+void ShardTest::test_CostShardsAreBalanced()
+{
+	// One expensive file takes a shard alone, the cheap ones fill the other one.
+	const auto paths = makePaths(11);
+	shard_helpers::FileCosts costs;
+	for (const auto &path : paths) {
+		costs[path] = 1.;
+	}
+	costs[paths.back()] = 10.;
+
+	const auto firstShard = selectPaths(paths, 0, 2, costs);
+	const auto secondShard = selectPaths(paths, 1, 2, costs);
+	const auto &expensiveShard = firstShard.size() == 1 ? firstShard : secondShard;
+	const auto &cheapShard = firstShard.size() == 1 ? secondShard : firstShard;
+	QCOMPARE(expensiveShard, std::set<QString>{paths.back()});
+	QCOMPARE(cheapShard.size(), paths.size() - 1);
+}
+
+void ShardTest::test_ReadFileCosts()
+{
+	const auto reportPath = m_dir.filePath("costs.jsonl");
+	QVERIFY(writeReport(reportPath, {makeFileRecord("a.cpp", "updated", 2.5),
+	                                 makeFileRecord("b.cpp", "unchanged", 1.),
+	                                 makeFileRecord("c.cpp", "skipped", 0.),
+	                                 makeFileRecord("d.cpp", "error", 0.),
+	                                 report_helpers::makeSummary(0, 1, apperror::Success)}));
+
+	// Skipped and failed files were not processed fully, so their durations are not costs.
+	const auto costs = report_helpers::readFileCosts(reportPath);
+	QCOMPARE(costs.size(), std::size_t(2));
+	QCOMPARE(costs.at("a.cpp"), 2.5);
+	QCOMPARE(costs.at("b.cpp"), 1.);
+}
+
+void ShardTest::test_MergeReports()
+{
+	const auto firstPath = m_dir.filePath("merge1.jsonl");
+	const auto secondPath = m_dir.filePath("merge2.jsonl");
+	const auto outputPath = m_dir.filePath("merged.jsonl");
+	QVERIFY(writeReport(firstPath, {makeFileRecord("a.cpp", "unchanged", 1.),
+	                                report_helpers::makeSummary(0, 2, apperror::Success)}));
+	QVERIFY(writeReport(secondPath, {makeFileRecord("b.cpp", "updated", 1.),
+	                                 report_helpers::makeSummary(1, 2, apperror::FilesChanged)}));
+
+	QCOMPARE(report_helpers::mergeReports({firstPath, secondPath}, outputPath),
+	         static_cast<int>(apperror::FilesChanged));
+
+	// Merged report looks like a report of one shard.
+	const auto records = test_helpers::readReport(outputPath);
+	QCOMPARE(records.size(), std::size_t(3));
+	QCOMPARE(records[0].value(cPath).toString(), QString("a.cpp"));
+	QCOMPARE(records[1].value(cPath).toString(), QString("b.cpp"));
+	QCOMPARE(records[2], report_helpers::makeSummary(0, 1, apperror::FilesChanged));
+}
+
+void ShardTest::test_MergeReportsOfDifferentRuns()
+{
+	const auto firstPath = m_dir.filePath("runs1.jsonl");
+	const auto secondPath = m_dir.filePath("runs2.jsonl");
+	QVERIFY(writeReport(firstPath, {report_helpers::makeSummary(0, 2, apperror::Success)}));
+	QVERIFY(writeReport(secondPath, {report_helpers::makeSummary(1, 3, apperror::Success)}));
+
+	QCOMPARE(report_helpers::mergeReports({firstPath, secondPath}, {}),
+	         static_cast<int>(apperror::RunArgError));
+}
+
+void ShardTest::test_MergeDuplicateShard()
+{
+	const auto firstPath = m_dir.filePath("duplicate1.jsonl");
+	const auto secondPath = m_dir.filePath("duplicate2.jsonl");
+	QVERIFY(writeReport(firstPath, {report_helpers::makeSummary(0, 2, apperror::Success)}));
+	QVERIFY(writeReport(secondPath, {report_helpers::makeSummary(0, 2, apperror::Success)}));
+
+	QCOMPARE(report_helpers::mergeReports({firstPath, secondPath}, {}),
+	         static_cast<int>(apperror::RunArgError));
+}
+
+void ShardTest::test_MergeMissingShard()
+{
+	const auto path = m_dir.filePath("missing.jsonl");
+	QVERIFY(writeReport(path, {report_helpers::makeSummary(0, 2, apperror::Success)}));
+
+	QCOMPARE(report_helpers::mergeReports({path}, {}), static_cast<int>(apperror::InternalError));
+}
+
+void ShardTest::test_MergeIncompleteReport()
+{
+	const auto firstPath = m_dir.filePath("incomplete1.jsonl");
+	const auto secondPath = m_dir.filePath("incomplete2.jsonl");
+	QVERIFY(writeReport(firstPath, {report_helpers::makeSummary(0, 2, apperror::Success)}));
+	// The shard has not written its summary.
+	QVERIFY(writeReport(secondPath, {makeFileRecord("b.cpp", "updated", 1.)}));
+
+	QCOMPARE(report_helpers::mergeReports({firstPath, secondPath}, {}),
+	         static_cast<int>(apperror::InternalError));
+}
+
+void ShardTest::test_WriteReport()
+{
+	const auto path = m_dir.filePath("written.jsonl");
+	{
+		ReportWriter writer(path);
+		FileReport report;
+		report.path = "a.cpp";
+		report.action = FileReport::Action::Updated;
+		report.changedFields = {header_fields::FieldType::Copyright};
+		report.authorShares = {{"Bill Gates", 1.}};
+		report.totalNsecs = 2'000'000;
+		writer.write(std::move(report));
+		writer.close(1, 2, apperror::FilesChanged);
+	}
+
+	const auto records = test_helpers::readReport(path);
+	QCOMPARE(records.size(), std::size_t(2));
+	const auto &record = records.front();
+	QCOMPARE(record.value(cPath).toString(), QString("a.cpp"));
+	QCOMPARE(record.value(cAction).toString(), QString("updated"));
+	QCOMPARE(record.value(cChangedFields).toArray(),
+	         QJsonArray{header_fields::toFieldName(header_fields::FieldType::Copyright)});
+	QCOMPARE(record.value(cAuthors).toArray().size(), 1);
+	QCOMPARE(record.value(cDurationMs).toDouble(), 2.);
+	QCOMPARE(records.back(), report_helpers::makeSummary(1, 2, apperror::FilesChanged));
+}
+
+void ShardTest::test_UnclosedReportIsIncomplete()
+{
+	const auto path = m_dir.filePath("unclosed.jsonl");
+	{
+		ReportWriter writer(path);
+		FileReport report;
+		report.path = "a.cpp";
+		writer.write(std::move(report));
+	}
+
+	// Records are written, but without the summary the shard is not finished.
+	QCOMPARE(test_helpers::readReport(path).size(), std::size_t(1));
+	QCOMPARE(report_helpers::mergeReports({path}, {}), static_cast<int>(apperror::InternalError));
+}
+
+QTEST_GUILESS_MAIN(ShardTest)
+
+#include "tst_ShardTest.moc"
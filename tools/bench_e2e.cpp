@@ -0,0 +1,339 @@
+// End-to-end benchmark: runs copyright_notice binaries over a repository with different numbers
+// of threads and reports throughput, peak memory and scaling efficiency.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <algorithm>
+#include <vector>
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+extern char **environ;
+#endif
+
+namespace {
+
+struct Binary
+{
+	QString name;
+	QString path;
+};
+
+struct Options
+{
+	QString repoPath;
+	QString staticConfigPath;
+	std::vector<Binary> binaries;
+	std::vector<int> threads;
+	int runs = 3;
+	QString outputPath;
+	QString gitJobs;
+};
+
+struct RunResult
+{
+	qint64 wallNsecs = 0;
+	qint64 peakRssKb = -1;
+	int exitCode = -1;
+};
+
+struct Measurement
+{
+	QString binary;
+	int threads = 0;
+	int files = 0;
+	qint64 bestWallNsecs = 0;
+	qint64 peakRssKb = -1;
+	double filesPerSec = 0;
+	double efficiency = 0;
+};
+
+[[noreturn]] void fail(const QString &message)
+{
+	QTextStream(stderr) << message << "\n";
+	std::exit(EXIT_FAILURE);
+}
+
+Options parseOptions(const QStringList &arguments)
+{
+	const QCommandLineOption binary{
+	    "binary", "Binary to measure as name=path, can be repeated.", "name=path"};
+	const QCommandLineOption threads{
+	    "threads", "Comma separated thread counts.", "list", "1,2,4,8"};
+	const QCommandLineOption runs{
+	    "runs", "Runs of every configuration, the fastest is reported.", "n", "3"};
+	const QCommandLineOption staticConfig{
+	    "static-config", "Static configuration, <repo>/static_config.json by default.", "path"};
+	const QCommandLineOption output{"output", "Write results to JSON file.", "path"};
+	const QCommandLineOption gitJobs{
+	    "git-jobs", "Value of --git-jobs of every run (not set by default).", "number|auto"};
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Runs end-to-end benchmark of copyright_notice.");
+	parser.addHelpOption();
+	parser.addOptions({binary, threads, runs, staticConfig, output, gitJobs});
+	parser.addPositionalArgument("repo", "Repository to process, e.g. from gen_synthetic_repo.");
+	parser.process(arguments);
+
+	if (parser.positionalArguments().size() != 1 || !parser.isSet(binary)) {
+		parser.showHelp(EXIT_FAILURE);
+	}
+
+	Options opts;
+	opts.repoPath = parser.positionalArguments().first();
+	opts.staticConfigPath = parser.isSet(staticConfig)
+	    ? parser.value(staticConfig)
+	    : opts.repoPath + "/static_config.json";
+	opts.outputPath = parser.value(output);
+	opts.gitJobs = parser.value(gitJobs);
+
+	for (const auto &value : parser.values(binary)) {
+		const int separator = value.indexOf('=');
+		if (separator <= 0 || separator == value.size() - 1) {
+			fail("--binary should be name=path, not " + value);
+		}
+		opts.binaries.push_back({value.left(separator), value.mid(separator + 1)});
+	}
+
+	for (const auto &value : parser.value(threads).split(',', Qt::SkipEmptyParts)) {
+		bool isOk{};
+		const int count = value.toInt(&isOk);
+		if (!isOk || count <= 0) {
+			fail("--threads should be a list of positive numbers.");
+		}
+		opts.threads.push_back(count);
+	}
+	std::sort(opts.threads.begin(), opts.threads.end());
+
+	bool isOk{};
+	opts.runs = parser.value(runs).toInt(&isOk);
+	if (!isOk || opts.runs <= 0) {
+		fail("--runs should be a positive number.");
+	}
+
+	return opts;
+}
+
+QStringList makeCommand(const Binary &binary, int threads, const Options &opts,
+                        const QString &reportPath)
+{
+	// clang-format off
+	QStringList command{
+	    binary.path
+	    , "--jobs", QString::number(threads)
+	    , "--dry", "--update-copyright", "--update-filename", "--update-authors"
+	    , "--static-config", opts.staticConfigPath
+	    , "--report", reportPath
+	    , opts.repoPath
+	};
+	// clang-format on
+	if (!opts.gitJobs.isEmpty()) {
+		command << "--git-jobs" << opts.gitJobs;
+	}
+	return command;
+}
+
+#ifdef Q_OS_UNIX
+
+// posix_spawn and wait4 are used instead of QProcess, because only wait4 reports peak memory of
+// exactly one child process.
+RunResult run(const QStringList &command)
+{
+	std::vector<QByteArray> storage;
+	for (const auto &argument : command) {
+		storage.emplace_back(argument.toLocal8Bit());
+	}
+	std::vector<char *> argv;
+	for (auto &argument : storage) {
+		argv.push_back(argument.data());
+	}
+	argv.push_back(nullptr);
+
+	// Processed files are printed in dry mode, which is not a part of measurement.
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+
+	QElapsedTimer timer;
+	timer.start();
+
+	pid_t pid{};
+	const int error = posix_spawnp(&pid, argv.front(), &actions, nullptr, argv.data(), environ);
+	posix_spawn_file_actions_destroy(&actions);
+	if (error != 0) {
+		fail("Failed to start " + command.join(' '));
+	}
+
+	int status{};
+	rusage usage{};
+	if (wait4(pid, &status, 0, &usage) != pid) {
+		fail("Failed to wait for " + command.join(' '));
+	}
+
+	RunResult result;
+	result.wallNsecs = timer.nsecsElapsed();
+	result.peakRssKb = usage.ru_maxrss;
+	result.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+	return result;
+}
+
+#else
+
+RunResult run(const QStringList &command)
+{
+	QProcess process;
+	process.setStandardOutputFile(QProcess::nullDevice());
+
+	QElapsedTimer timer;
+	timer.start();
+	process.start(command.first(), command.mid(1));
+	if (!process.waitForStarted()) {
+		fail("Failed to start " + command.join(' '));
+	}
+	process.waitForFinished(-1);
+
+	RunResult result;
+	result.wallNsecs = timer.nsecsElapsed();
+	result.exitCode = process.exitStatus() == QProcess::NormalExit ? process.exitCode() : -1;
+	return result;
+}
+
+#endif
+
+// Number of files, which were processed and not skipped.
+int countProcessedFiles(const QString &reportPath)
+{
+	QFile file(reportPath);
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		fail("Error opening report " + reportPath);
+	}
+
+	int count = 0;
+	while (!file.atEnd()) {
+		const auto record = QJsonDocument::fromJson(file.readLine()).object();
+		if (record.contains("path") && record.value("action").toString() != "skipped") {
+			count++;
+		}
+	}
+	return count;
+}
+
+Measurement measure(const Binary &binary, int threads, const Options &opts)
+{
+	QTemporaryDir tmpDir;
+	const auto reportPath = tmpDir.filePath("report.jsonl");
+	const auto command = makeCommand(binary, threads, opts, reportPath);
+
+	Measurement result{binary.name, threads};
+	for (int i = 0; i < opts.runs; i++) {
+		const auto runResult = run(command);
+		// Runs are dry, so they succeed, even if files would be updated.
+		if (runResult.exitCode != EXIT_SUCCESS) {
+			fail(QString("%1 exited with code %2").arg(command.join(' ')).arg(runResult.exitCode));
+		}
+
+		if (i == 0 || runResult.wallNsecs < result.bestWallNsecs) {
+			result.bestWallNsecs = runResult.wallNsecs;
+		}
+		result.peakRssKb = std::max(result.peakRssKb, runResult.peakRssKb);
+	}
+
+	result.files = countProcessedFiles(reportPath);
+	result.filesPerSec = result.files / (static_cast<double>(result.bestWallNsecs) / 1e9);
+	return result;
+}
+
+// Efficiency is the speedup relative to the lowest thread count, divided by the thread ratio.
+void fillEfficiency(std::vector<Measurement> &measurements)
+{
+	for (auto &measurement : measurements) {
+		const auto base = std::find_if(
+		    measurements.cbegin(), measurements.cend(),
+		    [&measurement](const auto &m) { return m.binary == measurement.binary; });
+		const double speedup =
+		    base->filesPerSec > 0 ? measurement.filesPerSec / base->filesPerSec : 0;
+		measurement.efficiency = speedup * base->threads / measurement.threads;
+	}
+}
+
+void printTable(const std::vector<Measurement> &measurements)
+{
+	QTextStream out(stdout);
+	out << QString("%1 %2 %3 %4 %5 %6\n")
+	           .arg("binary", -12)
+	           .arg("threads", 8)
+	           .arg("files", 8)
+	           .arg("files/s", 10)
+	           .arg("peak MiB", 10)
+	           .arg("efficiency", 11);
+	for (const auto &m : measurements) {
+		const auto peakMib =
+		    m.peakRssKb < 0 ? QString("n/a") : QString::number(m.peakRssKb / 1024.0, 'f', 1);
+		out << QString("%1 %2 %3 %4 %5 %6\n")
+		           .arg(m.binary, -12)
+		           .arg(m.threads, 8)
+		           .arg(m.files, 8)
+		           .arg(m.filesPerSec, 10, 'f', 1)
+		           .arg(peakMib, 10)
+		           .arg(QString::number(m.efficiency * 100, 'f', 0) + "%", 11);
+	}
+}
+
+void writeJson(const QString &path, const std::vector<Measurement> &measurements)
+{
+	QJsonArray results;
+	for (const auto &m : measurements) {
+		// clang-format off
+		results.append(QJsonObject{
+		    {"binary", m.binary}
+		    , {"threads", m.threads}
+		    , {"files", m.files}
+		    , {"wall_ms", static_cast<double>(m.bestWallNsecs) / 1e6}
+		    , {"files_per_sec", m.filesPerSec}
+		    , {"peak_rss_kb", m.peakRssKb}
+		    , {"efficiency", m.efficiency}
+		});
+		// clang-format on
+	}
+
+	QFile file(path);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		fail("Error opening " + path + ": " + file.errorString());
+	}
+	file.write(QJsonDocument(QJsonObject{{"results", results}}).toJson());
+}
+
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication app(argc, argv);
+	const auto opts = parseOptions(QCoreApplication::arguments());
+
+	std::vector<Measurement> measurements;
+	for (const auto &binary : opts.binaries) {
+		for (const int threads : opts.threads) {
+			measurements.emplace_back(measure(binary, threads, opts));
+		}
+	}
+	fillEfficiency(measurements);
+
+	printTable(measurements);
+	if (!opts.outputPath.isEmpty()) {
+		writeJson(opts.outputPath, measurements);
+	}
+	return EXIT_SUCCESS;
+}
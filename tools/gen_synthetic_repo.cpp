@@ -0,0 +1,347 @@
+// Generates a reproducible git repository for end-to-end benchmarks. History is written with a
+// single 'git fast-import' run, so even thousands of commits are generated in seconds.
+
+#include <QBuffer>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QTextStream>
+
+#include <array>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr qint64 cFirstCommitTime = 1577836800;  // 2020-01-01, so every header is outdated.
+constexpr qint64 cCommitInterval = 3600;
+constexpr auto cBranch = "master";
+
+// Single-parent commits with merge messages, as they are left by squash or rebase merges. These
+// are the shapes, which are detected as broken merges and skipped when blaming.
+// clang-format off
+constexpr std::array<const char *, 4> cBrokenMergeMessages{
+    "Merge branch 'feature-%1' into master"
+    , "Merge remote-tracking branch 'origin/feature-%1' -> master"
+    , "Revert \"Merge branch 'feature-%1' into master\""
+    , "Merge pull request #%1 from branch 'feature-%1'"
+};
+// clang-format on
+
+struct Options
+{
+	QString outputDir;
+	int files = 1000;
+	int commits = 2000;
+	int authors = 50;
+	int merges = 50;
+	int brokenMerges = 20;
+	int fileLines = 200;
+	int headerlessPercent = 10;
+	quint32 seed = 1;
+};
+
+struct File
+{
+	QString path;
+	std::vector<QByteArray> lines;
+};
+
+int intValue(const QCommandLineParser &parser, const QCommandLineOption &option)
+{
+	bool isOk{};
+	const int value = parser.value(option).toInt(&isOk);
+	if (!isOk || value < 0) {
+		QTextStream(stderr) << option.names().first() << " should be a non-negative number.\n";
+		std::exit(EXIT_FAILURE);
+	}
+	return value;
+}
+
+Options parseOptions(const QStringList &arguments)
+{
+	Options opts;
+
+	const auto defaultValue = [](int value) { return QString::number(value); };
+	const QCommandLineOption files{
+	    "files", "Number of source files.", "n", defaultValue(opts.files)};
+	const QCommandLineOption commits{
+	    "commits", "Number of commits on the main branch.", "n", defaultValue(opts.commits)};
+	const QCommandLineOption authors{
+	    "authors", "Number of distinct authors.", "n", defaultValue(opts.authors)};
+	const QCommandLineOption merges{
+	    "merges", "Number of merge commits with two parents.", "n", defaultValue(opts.merges)};
+	const QCommandLineOption brokenMerges{
+	    "broken-merges", "Number of single-parent commits with merge messages.", "n",
+	    defaultValue(opts.brokenMerges)};
+	const QCommandLineOption fileLines{
+	    "file-lines", "Average number of lines in a file.", "n", defaultValue(opts.fileLines)};
+	const QCommandLineOption headerless{
+	    "headerless-percent", "Percent of files without header.", "n",
+	    defaultValue(opts.headerlessPercent)};
+	const QCommandLineOption seed{
+	    "seed", "Seed of the generator.", "n", defaultValue(static_cast<int>(opts.seed))};
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Generates a synthetic git repository for benchmarks.");
+	parser.addHelpOption();
+	parser.addOptions(
+	    {files, commits, authors, merges, brokenMerges, fileLines, headerless, seed});
+	parser.addPositionalArgument("output_dir", "Directory of the new repository.");
+	parser.process(arguments);
+
+	if (parser.positionalArguments().size() != 1) {
+		parser.showHelp(EXIT_FAILURE);
+	}
+
+	opts.outputDir = parser.positionalArguments().first();
+	opts.files = std::max(1, intValue(parser, files));
+	opts.commits = std::max(1, intValue(parser, commits));
+	opts.authors = std::max(1, intValue(parser, authors));
+	opts.merges = intValue(parser, merges);
+	opts.brokenMerges = intValue(parser, brokenMerges);
+	opts.fileLines = std::max(1, intValue(parser, fileLines));
+	opts.headerlessPercent = std::min(100, intValue(parser, headerless));
+	opts.seed = static_cast<quint32>(intValue(parser, seed));
+	return opts;
+}
+
+QByteArray authorName(int author)
+{
+	return "Author Name" + QByteArray::number(author);
+}
+
+QByteArray makeHeader(const File &file, int author)
+{
+	const auto fileName = file.path.section('/', -1).toUtf8();
+	return "/******************************************************************************\n"
+	       "**\n"
+	       "** File      "
+	    + fileName
+	    + "\n"
+	      "** Author    "
+	    + authorName(author)
+	    + "\n"
+	      "** Copyright (c) 2020, Inc. All Rights Reserved.\n"
+	      "**\n"
+	      "** This file is part of Synthetic.\n"
+	      "**\n"
+	      "******************************************************************************/\n"
+	      "\n";
+}
+
+QByteArray makeCodeLine(int commit, int line)
+{
+	return "int value" + QByteArray::number(commit) + "_" + QByteArray::number(line) + " = "
+	    + QByteArray::number(commit * 31 + line) + ";\n";
+}
+
+struct RepoWriter
+{
+	explicit RepoWriter(QIODevice &stream)
+	    : m_stream(stream)
+	{}
+
+	int writeBlob(const File &file)
+	{
+		QByteArray content;
+		for (const auto &line : file.lines) {
+			content += line;
+		}
+		return writeBlob(content);
+	}
+
+	int writeBlob(const QByteArray &content)
+	{
+		const int mark = ++m_lastMark;
+		m_stream.write("blob\nmark :" + QByteArray::number(mark) + "\ndata "
+		               + QByteArray::number(content.size()) + "\n" + content + "\n");
+		return mark;
+	}
+
+	// Returns mark of the commit. Blobs are pairs of a path and a blob mark.
+	int writeCommit(const QByteArray &ref, int author, int commit, const QByteArray &message,
+	                int parentMark, int mergeMark,
+	                const std::vector<std::pair<QString, int>> &blobs)
+	{
+		const auto name = authorName(author);
+		const auto email = "author" + QByteArray::number(author) + "@example.com";
+		const auto time = QByteArray::number(cFirstCommitTime + commit * cCommitInterval);
+		const auto signature = name + " <" + email + "> " + time + " +0000\n";
+
+		const int mark = ++m_lastMark;
+		QByteArray data = "commit " + ref + "\nmark :" + QByteArray::number(mark) + "\n";
+		data += "author " + signature + "committer " + signature;
+		data += "data " + QByteArray::number(message.size()) + "\n" + message + "\n";
+		if (parentMark > 0) {
+			data += "from :" + QByteArray::number(parentMark) + "\n";
+		}
+		if (mergeMark > 0) {
+			data += "merge :" + QByteArray::number(mergeMark) + "\n";
+		}
+		for (const auto &[path, blobMark] : blobs) {
+			data += "M 100644 :" + QByteArray::number(blobMark) + " " + path.toUtf8() + "\n";
+		}
+		m_stream.write(data + "\n");
+		return mark;
+	}
+
+private:
+	QIODevice &m_stream;
+	int m_lastMark = 0;
+};
+
+QByteArray makeStaticConfig(const Options &opts)
+{
+	// Some authors have aliases, so alias resolution is also measured.
+	QJsonObject aliases;
+	for (int author = 0; author < opts.authors; author += 10) {
+		aliases.insert(QString(authorName(author)), QString("Canonical Name%1").arg(author));
+	}
+
+	// clang-format off
+	const QJsonObject root{
+	    {"author_aliases", aliases}
+	    , {"copyright_field_template", "(c) %CURRENT_YEAR%, Inc. All Rights Reserved."}
+	    , {"excluded_path_sections", QJsonArray{"3rdparty"}}
+	};
+	// clang-format on
+	return QJsonDocument(root).toJson();
+}
+
+void runGit(const QString &workingDir, const QStringList &arguments, const QByteArray &input = {})
+{
+	QProcess git;
+	git.setWorkingDirectory(workingDir);
+	git.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+	git.start("git", arguments);
+	if (!git.waitForStarted()) {
+		QTextStream(stderr) << "Failed to start git.\n";
+		std::exit(EXIT_FAILURE);
+	}
+
+	git.write(input);
+	git.closeWriteChannel();
+	git.waitForFinished(-1);
+	if (git.exitStatus() != QProcess::NormalExit || git.exitCode() != EXIT_SUCCESS) {
+		QTextStream(stderr) << "git " << arguments.join(' ') << " failed.\n";
+		std::exit(EXIT_FAILURE);
+	}
+}
+
+void generate(const Options &opts)
+{
+	std::mt19937 random(opts.seed);
+	const auto randomInt = [&random](int max) {
+		return std::uniform_int_distribution<int>(0, max - 1)(random);
+	};
+
+	std::vector<File> files(static_cast<std::size_t>(opts.files));
+	for (int i = 0; i < opts.files; i++) {
+		auto &file = files[static_cast<std::size_t>(i)];
+		file.path = QString("src/module%1/File%2.%3").arg(i % 32).arg(i).arg(i % 4 ? "cpp" : "h");
+
+		const int author = randomInt(opts.authors);
+		if (randomInt(100) >= opts.headerlessPercent) {
+			file.lines.emplace_back(makeHeader(file, author));
+		}
+
+		const int lineCount = std::max(1, opts.fileLines / 2 + randomInt(opts.fileLines));
+		for (int line = 0; line < lineCount; line++) {
+			file.lines.emplace_back(makeCodeLine(0, line));
+		}
+	}
+
+	QByteArray stream;
+	QBuffer buffer(&stream);
+	buffer.open(QIODevice::WriteOnly);
+	RepoWriter writer(buffer);
+
+	const QByteArray mainRef = QByteArray("refs/heads/") + cBranch;
+	const auto modifyFile = [&](File &file, int commit) {
+		// Lines after the header are replaced, so blame is spread over many commits.
+		const int firstCodeLine = file.lines.front().startsWith("/***") ? 1 : 0;
+		const int codeLines = static_cast<int>(file.lines.size()) - firstCodeLine;
+		const int changedLines = 1 + randomInt(std::max(1, codeLines / 10));
+		for (int i = 0; i < changedLines && codeLines > 0; i++) {
+			const auto line = static_cast<std::size_t>(firstCodeLine + randomInt(codeLines));
+			file.lines[line] = makeCodeLine(commit, static_cast<int>(line));
+		}
+		return std::pair{file.path, writer.writeBlob(file)};
+	};
+
+	// Initial commit adds all files.
+	std::vector<std::pair<QString, int>> blobs;
+	for (const auto &file : files) {
+		blobs.emplace_back(file.path, writer.writeBlob(file));
+	}
+	blobs.emplace_back("static_config.json", writer.writeBlob(makeStaticConfig(opts)));
+	int head = writer.writeCommit(mainRef, 0, 0, "Initial commit", 0, 0, blobs);
+
+	// Merges and broken merges are spread evenly over the history.
+	const int mergeEvery = opts.merges > 0 ? std::max(1, opts.commits / (opts.merges + 1)) : 0;
+	const int brokenEvery =
+	    opts.brokenMerges > 0 ? std::max(1, opts.commits / (opts.brokenMerges + 1)) : 0;
+	int mergeCount = 0;
+	int brokenCount = 0;
+
+	for (int commit = 1; commit < opts.commits; commit++) {
+		const int author = randomInt(opts.authors);
+		auto &file = files[static_cast<std::size_t>(randomInt(opts.files))];
+
+		if (mergeEvery > 0 && mergeCount < opts.merges && commit % mergeEvery == 0) {
+			// Feature branch with one commit, merged back with a real merge commit.
+			const QByteArray featureRef = "refs/heads/feature-" + QByteArray::number(mergeCount);
+			// Merge commit takes the tree of the feature branch, as there are no conflicts.
+			const auto change = modifyFile(file, commit);
+			const int featureHead =
+			    writer.writeCommit(featureRef, author, commit, "Feature work", head, 0, {change});
+			const auto message = "Merge branch 'feature-" + QByteArray::number(mergeCount)
+			    + "' into " + cBranch;
+			head = writer.writeCommit(mainRef, randomInt(opts.authors), commit, message, head,
+			                          featureHead, {change});
+			mergeCount++;
+			continue;
+		}
+
+		QByteArray message = "Change " + QByteArray::number(commit);
+		if (brokenEvery > 0 && brokenCount < opts.brokenMerges && commit % brokenEvery == 0) {
+			const auto *shape = cBrokenMergeMessages[brokenCount % cBrokenMergeMessages.size()];
+			message = QString(shape).arg(brokenCount).toUtf8();
+			brokenCount++;
+		}
+
+		head = writer.writeCommit(mainRef, author, commit, message, head, 0,
+		                          {modifyFile(file, commit)});
+	}
+
+	buffer.write("done\n");
+
+	if (!QDir().mkpath(opts.outputDir)) {
+		QTextStream(stderr) << "Cannot create " << opts.outputDir << ".\n";
+		std::exit(EXIT_FAILURE);
+	}
+
+	runGit(opts.outputDir, {"init", "--quiet"});
+	runGit(opts.outputDir, {"fast-import", "--quiet", "--done"}, stream);
+	runGit(opts.outputDir, {"symbolic-ref", "HEAD", QString::fromLatin1(mainRef)});
+	runGit(opts.outputDir, {"reset", "--hard", "--quiet", cBranch});
+
+	QTextStream(stdout) << "Generated " << opts.files << " files, " << opts.commits
+	                    << " commits (" << mergeCount << " merges, " << brokenCount
+	                    << " broken merges) by " << opts.authors << " authors in "
+	                    << opts.outputDir << ".\n";
+}
+
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication app(argc, argv);
+	generate(parseOptions(QCoreApplication::arguments()));
+	return EXIT_SUCCESS;
+}